@@ -7,10 +7,23 @@
 
 #include "tree_sitter/cxx/point.h"
 #include "tree_sitter/cxx/lang.h"
+#include "tree_sitter/cxx/lines.h"
 #include "tree_sitter/cxx/node.h"
 #include "tree_sitter/cxx/cursor.h"
 #include "tree_sitter/cxx/tree.h"
 #include "tree_sitter/cxx/parser.h"
+#include "tree_sitter/cxx/nodemap.h"
+#include "tree_sitter/cxx/parallel.h"
+#include "tree_sitter/cxx/positions.h"
+#include "tree_sitter/cxx/query.h"
+#include "tree_sitter/cxx/fusedquery.h"
+#include "tree_sitter/cxx/highlighter.h"
+#include "tree_sitter/cxx/querycache.h"
+#include "tree_sitter/cxx/queryrunner.h"
+#include "tree_sitter/cxx/serializer.h"
+#include "tree_sitter/cxx/symbolindex.h"
+#include "tree_sitter/cxx/tagger.h"
+#include "tree_sitter/cxx/typed.h"
 
 namespace TreeSitter {
 
@@ -0,0 +1,108 @@
+/**
+ * @file tree_sitter/cpp/children.h
+ * @brief Lazy views over the children of a node.
+ */
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include "tree_sitter/api.h"
+
+namespace TreeSitter {
+
+class Node;
+class Tree;
+
+/**
+ * @brief A lazy view over the (named) children of a node.
+ *
+ * Created by Node.childRange() and Node.namedChildRange().
+ * Children are produced one at a time by a tree cursor borrowed from
+ * a per-thread pool, so iterating does not build a vector.
+ *
+ * ```c++
+ * for (Node child : node.namedChildRange()) {
+ *     std::cout << child.type() << "\n";
+ * }
+ * ```
+ *
+ * @note This is a single-pass input range. Every iterator shares the
+ * cursor of the range it came from, and calling begin() again restarts
+ * the iteration.
+ */
+class ChildRange {
+public:
+    /** Marks the end of the range. */
+    struct sentinel {};
+
+    /**
+     * @brief Input iterator over the children.
+     */
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Node;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Node;
+
+        iterator() = default;
+        /** @internal Created by ChildRange. */
+        explicit iterator(ChildRange* range) : m_range(range) {}
+
+        /** The current child. */
+        Node operator*() const;
+        /** The current child as a raw TSNode. */
+        TSNode node() const;
+        /** The field of the current child (0 if none). */
+        TSFieldId fieldId() const;
+        /** Move to the next child. */
+        iterator& operator++();
+        /** Move to the next child. */
+        void operator++(int) { ++*this; }
+
+        friend bool operator==(const iterator& it, sentinel) { return it.done(); }
+        friend bool operator==(sentinel, const iterator& it) { return it.done(); }
+        friend bool operator!=(const iterator& it, sentinel) { return !it.done(); }
+        friend bool operator!=(sentinel, const iterator& it) { return !it.done(); }
+    private:
+        bool done() const { return m_range == nullptr || m_range->m_done; }
+
+        ChildRange* m_range = nullptr;
+    };
+
+    /** @internal Created by Node. */
+    ChildRange(const Tree* tree, TSNode parent, bool named);
+    /** @internal Move constructor. */
+    ChildRange(ChildRange&& range) noexcept;
+    ChildRange(const ChildRange&) = delete;
+    ChildRange& operator=(const ChildRange&) = delete;
+    /** Destructor. */
+    ~ChildRange();
+
+    /** Start (or restart) the iteration. */
+    iterator begin();
+    /** End of the range. */
+    sentinel end() const { return {}; }
+
+    /** Number of children in this range. */
+    uint32_t size() const;
+    /** Returns `true` if there are no children. */
+    bool empty() const;
+    /** The first child, without walking the others. */
+    std::optional<Node> first() const;
+    /** The last child, without walking the others. */
+    std::optional<Node> last() const;
+private:
+    void advance(bool first);
+
+    const Tree* m_tree = nullptr;
+    TSNode m_parent;
+    TSTreeCursor m_cursor;
+    bool m_named = false;
+    bool m_hasCursor = false;
+    bool m_done = true;
+};
+
+}
@@ -0,0 +1,78 @@
+/**
+ * @file tree_sitter/cpp/fusedquery.h
+ * @brief Several queries run in one pass.
+ */
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "tree_sitter/cxx/node.h"
+#include "tree_sitter/cxx/query.h"
+
+namespace TreeSitter {
+
+/**
+ * @brief Runs several queries in a single traversal.
+ *
+ * The patterns of every query are compiled into one query, so a tree is
+ * walked once instead of once per query. Results are split back per
+ * query, with the pattern and capture indices of the original query:
+ *
+ * ```c++
+ * FusedQuery fused({ highlights, locals, tags });
+ * auto matches = fused.matches(tree.rootNode());
+ * for (const Query::Match& match : matches[1]) { ... } // locals
+ * ```
+ *
+ * Predicates behave as in the original queries. Properties set with
+ * `#set!` and friends are read from the original queries.
+ */
+class FusedQuery {
+public:
+    /**
+     * @brief Match callback.
+     *
+     * @param query Index of the original query.
+     * @param match The match, with original indices; only valid during the call.
+     */
+    using Visitor = std::function<void (size_t query, const Query::Match& match)>;
+
+    /**
+     * @brief Fuse queries.
+     *
+     * @throws std::invalid_argument If the queries are for different languages.
+     */
+    explicit FusedQuery(const std::vector<Query>& queries);
+    /** @internal Copy constructor. */
+    FusedQuery(const FusedQuery& query);
+    /** @internal Copy assignment constructor. */
+    FusedQuery& operator=(const FusedQuery& query);
+    /** Destructor. */
+    ~FusedQuery();
+
+    /** Number of fused queries. */
+    size_t queryCount() const;
+    /** The `index`-th original query. */
+    const Query& query(size_t index) const;
+    /** The combined query. */
+    const Query& fused() const;
+
+    /**
+     * @brief Run every query on `node`.
+     *
+     * The cursor's range and match limit apply to the combined query.
+     */
+    void visit(QueryCursor& cursor, const Node& node, const Visitor& visitor) const;
+
+    /** The matches of every query, indexed by query. */
+    std::vector<std::vector<Query::Match>> matches(const Node& node) const;
+    /** The captures of every query in document order, indexed by query. */
+    std::vector<std::vector<Query::Capture>> captures(const Node& node) const;
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+
+}
@@ -0,0 +1,132 @@
+/**
+ * @file tree_sitter/cpp/highlighter.h
+ * @brief Syntax highlighting.
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "tree_sitter/cxx/point.h"
+#include "tree_sitter/cxx/query.h"
+
+namespace TreeSitter {
+
+class Tree;
+
+/**
+ * @brief Turns the captures of a highlights query into spans.
+ *
+ * Works like tree-sitter-highlight: each capture whose name is a
+ * recognized highlight name is a candidate, and the candidates are
+ * resolved into non-overlapping spans, in order:
+ *
+ * - A node captured by several patterns gets the highlight of the
+ *   pattern with the highest `priority` property (`#set! priority 110`,
+ *   100 by default), then of the first pattern.
+ * - Inner nodes override the nodes around them.
+ * - Injected languages override the node they are injected in.
+ *
+ * Capture names are matched to highlight names by their dotted
+ * prefix: with the names `function` and `function.builtin`, the
+ * capture `@function.builtin.static` is a `function.builtin`, and
+ * `@function.method` a `function`. Other captures are ignored.
+ *
+ * ```c++
+ * Highlighter highlighter({ "keyword", "string" }, { highlights, injections });
+ * highlighter.addInjection("javascript", { javascriptHighlights });
+ * for (const Highlighter::Span& span : highlighter.highlight(tree)) { ... }
+ * ```
+ */
+class Highlighter {
+public:
+    /**
+     * @brief Queries of a highlighted language.
+     */
+    struct Config {
+        /** Highlights query; also gives the language. */
+        Query highlights;
+        /**
+         * @brief Injections query, if the language embeds others.
+         *
+         * Uses the `@injection.content` capture for the embedded text, and
+         * the `@injection.language` capture or the `injection.language`
+         * property for its language. The children of the content node are
+         * skipped, unless the pattern sets `injection.include-children`.
+         */
+        std::optional<Query> injections = std::nullopt;
+    };
+
+    /**
+     * @brief A highlighted area of the source.
+     */
+    struct Span {
+        /** Starting offset. */
+        Index startIndex;
+        /** Ending offset. */
+        Index endIndex;
+        /** Index of the highlight name. */
+        uint32_t highlight;
+
+        bool operator==(const Span& span) const;
+        bool operator!=(const Span& span) const;
+    };
+
+    /**
+     * @brief Spans of an area that changed after an edit.
+     */
+    struct Update {
+        /** Starting offset, in the new source. */
+        Index startIndex;
+        /** Ending offset, in the new source. */
+        Index endIndex;
+        /** Every span of the area, clipped to it. */
+        std::vector<Span> spans;
+    };
+
+    /**
+     * @brief Construct a new Highlighter.
+     *
+     * @param names Recognized highlight names.
+     * @param config Queries of the highlighted language.
+     */
+    Highlighter(const std::vector<std::string>& names, const Config& config);
+    /** @internal Copy constructor. */
+    Highlighter(const Highlighter& highlighter);
+    /** @internal Copy assignment constructor. */
+    Highlighter& operator=(const Highlighter& highlighter);
+    /** Destructor. */
+    ~Highlighter();
+
+    /** Recognized highlight names, indexed by Span.highlight. */
+    const std::vector<std::string>& names() const;
+
+    /** Highlight the text injected as language `name`. */
+    void addInjection(const std::string& name, const Config& config);
+
+    /** Every span of a tree, in order. */
+    std::vector<Span> highlight(const Tree& tree) const;
+
+    /** The spans between two offsets, clipped to them. */
+    std::vector<Span> highlight(const Tree& tree, Index startIndex, Index endIndex) const;
+
+    /**
+     * @brief The spans that changed after an edit.
+     *
+     * `oldTree` is the tree `edit` was applied to, and `newTree` the tree
+     * parsed again from it. The changed areas are those reported by
+     * Tree.getChangedRanges() and the edited text, extended to whole
+     * lines, in order and without overlaps.
+     */
+    std::vector<Update> update(const Tree& oldTree, const Tree& newTree, const Edit& edit) const;
+
+    /** Bring the spans of the old tree up to date with the result of update(). */
+    static void apply(std::vector<Span>& spans, const Edit& edit, const std::vector<Update>& updates);
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+
+}
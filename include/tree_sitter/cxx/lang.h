@@ -4,8 +4,12 @@
  */
 #pragma once
 
+#include <cstdint>
+#include <initializer_list>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "tree_sitter/api.h"
 
@@ -13,6 +17,64 @@ namespace TreeSitter {
 
 class Query;
 
+/**
+ * @brief A set of node type IDs.
+ *
+ * Stored as a bitset indexed by symbol, so membership tests are O(1).
+ * Build one with Language.symbolsForTypes() and reuse it.
+ */
+class SymbolSet {
+public:
+    /** Construct an empty set. */
+    SymbolSet() = default;
+    /** Construct a set from a list of symbols. */
+    SymbolSet(std::initializer_list<TSSymbol> symbols);
+
+    /** Add a symbol. */
+    void insert(TSSymbol symbol);
+    /** Remove a symbol. */
+    void erase(TSSymbol symbol);
+    /** Number of symbols in this set. */
+    size_t size() const;
+    /** Returns `true` if this set is empty. */
+    bool empty() const;
+
+    /** Test if a symbol belongs to this set. */
+    bool contains(TSSymbol symbol) const {
+        const size_t word = symbol / 64;
+        return word < m_bits.size() && (m_bits[word] >> (symbol % 64)) & 1;
+    }
+private:
+    std::vector<uint64_t> m_bits;
+};
+
+/**
+ * @brief A resolved field name.
+ *
+ * Look a field up once with Language.field() and pass the handle to
+ * Node.childForField() to skip the name lookup on every call. An invalid
+ * handle (for names the language does not have) matches no child.
+ */
+class FieldId {
+public:
+    /** Construct an invalid field. */
+    constexpr FieldId() = default;
+    /** Wrap a raw tree-sitter field ID. */
+    constexpr explicit FieldId(TSFieldId id) : m_id(id) { }
+
+    /** The raw tree-sitter field ID, 0 if invalid. */
+    constexpr TSFieldId id() const { return m_id; }
+    /** Returns `true` if this field exists in its language. */
+    constexpr bool valid() const { return m_id != 0; }
+    /** Returns `true` if this field exists in its language. */
+    constexpr explicit operator bool() const { return m_id != 0; }
+
+    constexpr bool operator==(FieldId other) const { return m_id == other.m_id; }
+    constexpr bool operator!=(FieldId other) const { return m_id != other.m_id; }
+private:
+    TSFieldId m_id = 0;
+};
+
 /**
  * @brief A programming language.
  *
@@ -46,6 +108,21 @@ public:
         TSX
     };
 
+    /**
+     * @brief Guess the language of a file.
+     *
+     * Checks, in order: Emacs and Vim modelines, the file extension,
+     * the `#!` line and a few unambiguous content markers. Headers
+     * ending in `.h` are C++ if they use C++-only keywords, C otherwise.
+     * At most the first 4 KiB of `content` are examined, so the start
+     * of the file is enough.
+     *
+     * @param path File path or name.
+     * @param content The first bytes of the file, if available.
+     * @return The syntax, or nothing if no rule matched.
+     */
+    static std::optional<Syntax> detect(std::string_view path, std::string_view content = {});
+
     /**
      * @brief Construct a new Language object.
      */
@@ -67,12 +144,22 @@ public:
     uint32_t version() const;
     /** Number of fields in this language. */
     int fieldCount() const;
-    /** List of all recognized fields. */
-    std::vector<std::string> fields() const;
+    /**
+     * @brief Name of every field, indexed by field ID.
+     *
+     * Field IDs start at 1, so the first entry is empty. The list is
+     * shared by every Language of the same grammar.
+     */
+    const std::vector<std::string>& fields() const;
     /** Number of node types in this language. */
     int nodeTypeCount() const;
-    /** List of all recognized node types. */
-    std::vector<std::string> nodeTypes() const;
+    /**
+     * @brief Name of every node type, indexed by symbol ID.
+     *
+     * Includes hidden and auxiliary symbols, so that Node.typeId() can
+     * index it. The list is shared by every Language of the same grammar.
+     */
+    const std::vector<std::string>& nodeTypes() const;
 
     /**
      * @brief Allows access to the internal TSLanguage.
@@ -88,9 +175,19 @@ public:
 
     /** Return the name of a field. */
     std::string fieldNameForId(int fieldId);
-    /** Return the ID of a field. */
+    /** Return the ID of a field, or -1 if it does not exist. */
     int fieldIdForName(const std::string& fieldName);
 
+    /**
+     * @brief Resolve a field name.
+     *
+     * A binary search over the sorted field names of the language.
+     * The result is invalid if the language has no such field.
+     */
+    FieldId field(std::string_view name) const;
+    /** The name of a field, or an empty string if it is invalid. */
+    std::string_view fieldName(FieldId field) const;
+
     /**
      * @brief Lookup the id for a node type.
      * @return int Node id (0 if not found).
@@ -103,6 +200,14 @@ public:
      */
     std::string nodeTypeForId(int typeId);
 
+    /**
+     * @brief Resolve node type names to IDs.
+     *
+     * Every symbol with a matching name is included, so aliased
+     * symbols are found as well.
+     */
+    SymbolSet symbolsForTypes(const std::vector<std::string>& types) const;
+
     /** Determines if a node type is named. */
     bool nodeTypeIsNamed(int typeId);
     /** Determines if a node type is visible. */
@@ -0,0 +1,90 @@
+/**
+ * @file tree_sitter/cpp/lines.h
+ * @brief Line index for converting between offsets and positions.
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include "tree_sitter/api.h"
+#include "tree_sitter/cxx/point.h"
+
+namespace TreeSitter {
+
+/**
+ * @brief Start offset of every line in a source string.
+ *
+ * Built once per tree by Tree.lineIndex(), with a vectorized newline
+ * scan. Conversions are binary searches over the line starts.
+ * Like tree-sitter, rows are separated by `\n` and columns are
+ * counted in bytes.
+ *
+ * Lines containing non-ASCII text also get a table of their multi-byte
+ * characters, so columns can be converted to UTF-16 code units or code
+ * points. Pure ASCII lines are found with a vectorized scan and need no
+ * table, since every unit is one byte there.
+ */
+class LineIndex {
+public:
+    /** Index a source string. */
+    LineIndex(std::shared_ptr<const std::string> source);
+    /** Index a copy of a source string. */
+    LineIndex(const std::string& source);
+    /** @internal Copy constructor. */
+    LineIndex(const LineIndex& index);
+    /** @internal Copy assignment constructor. */
+    LineIndex& operator=(const LineIndex& index);
+    /** Destructor. */
+    ~LineIndex();
+
+    /** Number of lines (at least 1). */
+    uint32_t lineCount() const;
+    /** Offset of the first byte of a line. */
+    Index lineStart(uint32_t row) const;
+    /** Offset just past the last byte of a line, excluding the line break. */
+    Index lineEnd(uint32_t row) const;
+
+    /**
+     * @brief The text of a line, without its line break.
+     *
+     * A `\r` before the `\n` is removed as well.
+     * Valid for as long as this index is alive.
+     */
+    std::string_view line(uint32_t row) const;
+
+    /** Convert a byte offset to a position. */
+    Point offsetToPoint(Index offset) const;
+
+    /**
+     * @brief Convert a position to a byte offset.
+     *
+     * Columns past the end of the line are clamped to the line end and
+     * rows past the end of the source map to the end of the source.
+     */
+    Index pointToOffset(Point point) const;
+
+    /** Returns `true` if a line only contains ASCII characters. */
+    bool isAscii(uint32_t row) const;
+
+    /**
+     * @brief Convert a column of a line between units.
+     *
+     * Columns inside a multi-byte character (or inside a surrogate pair)
+     * are moved to the start of that character. Columns past the end of
+     * the line are clamped to the line end.
+     */
+    uint32_t convertColumn(uint32_t row, uint32_t column,
+        ColumnUnit from, ColumnUnit to) const;
+
+    /** Convert the column of a position between units. */
+    Point convertPoint(Point point, ColumnUnit from, ColumnUnit to) const;
+
+    /** Approximate heap memory used by this index, in bytes. */
+    size_t memoryUsage() const;
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+
+}
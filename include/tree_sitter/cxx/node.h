@@ -4,13 +4,21 @@
  */
 #pragma once
 
+#include <cstdint>
+#include <functional>
 #include <optional>
+#include <string>
+#include <vector>
 #include "tree_sitter/api.h"
+#include "tree_sitter/cxx/children.h"
+#include "tree_sitter/cxx/lang.h"
 #include "tree_sitter/cxx/point.h"
+#include "tree_sitter/cxx/traversal.h"
 
 namespace TreeSitter {
 
 class Cursor;
+class SymbolSet;
 class Tree;
 
 /**
@@ -21,26 +29,32 @@ class Tree;
 class Node {
 public:
     /** @internal Create a new Node. */
-    Node(const Tree* tree, TSNode node);
+    Node(const Tree* tree, TSNode node) : m_tree(tree), m_node(node) { }
     /** @internal Copy constructor. */
-    Node(const Node& lang);
+    Node(const Node& node) = default;
     /** @internal Copy assignment constructor. */
-    Node& operator=(const Node& node);
+    Node& operator=(const Node& node) = default;
     /** @internal Destructor. */
-    ~Node();
+    ~Node() = default;
 
-    bool operator==(const Node& node);
-    bool operator!=(Node node);
+    /** Test if two handles refer to the same node of the same tree. */
+    bool operator==(const Node& node) const;
+    /** Test if two handles refer to different nodes. */
+    bool operator!=(const Node& node) const;
 
-#if 0
-    //Disabled for portability/safety reasons.
+    /**
+     * @brief Node identity.
+     *
+     * Unique among the nodes of one tree and stable for as long as the
+     * tree is alive. Do not compare IDs across trees: a node that an
+     * incremental parse reuses may or may not keep its ID.
+     */
     uint64_t id() const;
-#endif
 
     /** @internal Access to the internal TSNode. */
-    TSNode node() const;
+    TSNode node() const { return m_node; }
     /** @internal Access to the internal Tree. */
-    const Tree* tree() const;
+    const Tree* tree() const { return m_tree; }
 
     /** Node ID. */
     int typeId() const;
@@ -56,21 +70,37 @@ public:
     Point startPosition() const;
     /** Ending position. */
     Point endPosition() const;
+    /** Starting position, with the column counted in `unit`. */
+    Point startPosition(ColumnUnit unit) const;
+    /** Ending position, with the column counted in `unit`. */
+    Point endPosition(ColumnUnit unit) const;
     /** Starting offset. */
     Index startIndex() const;
     /** Ending offset. */
     Index endIndex() const;
 
-    /** The parent node. */
+    /**
+     * @brief The parent node.
+     *
+     * O(depth), or O(1) once Tree.setParentIndexEnabled() is on.
+     */
     Node parent() const;
+    /** Every ancestor, from the parent up to the root node. */
+    std::vector<Node> ancestors() const;
+    /** Number of ancestors (0 for the root node). */
+    uint32_t depth() const;
     /** Number of children owned by this node. */
     uint32_t childCount() const;
     /** Every child belonging to this node. */
     std::vector<Node> children() const;
+    /** Lazily iterate over every child, without building a vector. */
+    ChildRange childRange() const;
     /** Number of named children owned by this node. */
     uint32_t namedChildCount() const;
     /** Every named child belonging to this node. */
     std::vector<Node> namedChildren() const;
+    /** Lazily iterate over every named child, without building a vector. */
+    ChildRange namedChildRange() const;
 
     /** Get the first child. */
     std::optional<Node> firstChild() const;
@@ -120,6 +150,8 @@ public:
     std::optional<Node> childForFieldId(int fieldId);
     /** Returns a child based on its Field Name. */
     std::optional<Node> childForFieldName(const std::string& fieldName);
+    /** Returns a child based on a field resolved with Language.field(). */
+    std::optional<Node> childForField(FieldId field) const;
 
     /**
      * @brief Returns a descendant.
@@ -140,6 +172,27 @@ public:
         Point startPosition = Point { 0, 0 },
         Point endPosition = Point { 0, 0 });
 
+    /**
+     * @brief Returns a list of descendants.
+     *
+     * Resolve the types once with Language.symbolsForTypes() and reuse
+     * the set. Subtrees outside of [startIndex, endIndex) are skipped.
+     */
+    std::vector<Node> descendantsOfType(const SymbolSet& symbols,
+        Index startIndex = 0,
+        Index endIndex = UINT32_MAX) const;
+
+    /**
+     * @brief Visit descendants without collecting them.
+     *
+     * @param callback Called for each match, in document order.
+     *   Return `false` to stop the walk.
+     */
+    void visitDescendantsOfType(const SymbolSet& symbols,
+        const std::function<bool (const Node& node)>& callback,
+        Index startIndex = 0,
+        Index endIndex = UINT32_MAX) const;
+
     /** Returns a named descendant. */
     Node namedDescendantForIndex(int index);
     /** Returns a named descendant. */
@@ -153,6 +206,15 @@ public:
     /** Returns a named descendant. */
     Node namedDescendantForPosition(Point startPosition, Point endPosition);
 
+    /**
+     * @brief Walk this node and all of its descendants.
+     *
+     * @param order Visiting order.
+     * @param namedOnly Skip anonymous nodes.
+     */
+    Traversal descendants(Traversal::Order order = Traversal::PreOrder,
+        bool namedOnly = false) const;
+
     /**
      * @brief Create a Cursor to traverse this node.
      * 
@@ -160,8 +222,24 @@ public:
      */
     Cursor walk();
 private:
-    struct Private;
-    std::unique_ptr<Private> d;
+    const Tree* m_tree;
+    TSNode m_node;
+};
+
+}
+
+namespace std {
+
+/**
+ * @brief Hashes nodes by identity, so they can be used as keys.
+ */
+template <>
+struct hash<TreeSitter::Node> {
+    size_t operator()(const TreeSitter::Node& node) const noexcept {
+        const uint64_t tree = reinterpret_cast<uintptr_t>(node.node().tree);
+        const uint64_t id = node.id();
+        return static_cast<size_t>((id ^ (tree * 0x9e3779b97f4a7c15ULL)) * 0xff51afd7ed558ccdULL);
+    }
 };
 
 }
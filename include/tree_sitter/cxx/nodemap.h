@@ -0,0 +1,163 @@
+/**
+ * @file tree_sitter/cpp/nodemap.h
+ * @brief Dense per-node side tables.
+ */
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+#include "tree_sitter/api.h"
+#include "tree_sitter/cxx/node.h"
+#include "tree_sitter/cxx/tree.h"
+
+namespace TreeSitter {
+
+/**
+ * @brief Numbers every node of a tree in pre-order.
+ *
+ * Built once per tree by Tree.nodeIndex(). Index 0 is the root node and
+ * the numbering matches a full Node.descendants() pre-order walk of the
+ * root, so walks can track the index themselves instead of looking it up.
+ */
+class NodeIndex {
+public:
+    /** Returned by indexOf() for nodes outside of the tree. */
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    /** @internal Created by Tree. */
+    NodeIndex(const Tree* tree);
+    /** @internal Copy constructor. */
+    NodeIndex(const NodeIndex& index);
+    /** @internal Copy assignment constructor. */
+    NodeIndex& operator=(const NodeIndex& index);
+    /** Destructor. */
+    ~NodeIndex();
+
+    /** Number of nodes in the tree. */
+    size_t size() const;
+    /** Pre-order position of a node, or `npos`. */
+    size_t indexOf(const Node& node) const;
+    /** Pre-order position of a node, or `npos`. */
+    size_t indexOf(TSNode node) const;
+    /** The node at a pre-order position. */
+    Node nodeAt(size_t index) const;
+    /** The node at a pre-order position, as a raw TSNode. */
+    TSNode rawNodeAt(size_t index) const;
+    /** Approximate heap memory used by this index, in bytes. */
+    size_t memoryUsage() const;
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+
+/**
+ * @brief Parent and depth of every node of a tree.
+ *
+ * Built in one pass on top of NodeIndex by Tree.parentIndex().
+ * Once Tree.setParentIndexEnabled() is on, Node.parent(),
+ * Node.ancestors() and Node.depth() use it instead of re-descending
+ * from the root.
+ */
+class ParentIndex {
+public:
+    /** @internal Created by Tree. */
+    ParentIndex(std::shared_ptr<const NodeIndex> nodes);
+    /** @internal Copy constructor. */
+    ParentIndex(const ParentIndex& index);
+    /** @internal Copy assignment constructor. */
+    ParentIndex& operator=(const ParentIndex& index);
+    /** Destructor. */
+    ~ParentIndex();
+
+    /** The underlying node numbering. */
+    const NodeIndex& nodes() const;
+    /** Pre-order position of the parent, or `NodeIndex::npos` for the root. */
+    size_t parentOf(size_t index) const;
+    /** Depth below the root node. */
+    uint32_t depthOf(size_t index) const;
+    /** The parent of a node, if it belongs to this tree and is not the root. */
+    std::optional<Node> parent(const Node& node) const;
+    /**
+     * @brief Approximate heap memory used, in bytes.
+     *
+     * Includes the NodeIndex it is built on.
+     */
+    size_t memoryUsage() const;
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+
+/**
+ * @brief Attaches a value to every node of a tree.
+ *
+ * Values are stored in one vector, ordered like NodeIndex, so lookups
+ * are a hash probe and an array access.
+ *
+ * ```c++
+ * NodeMap<TypeInfo> types(tree);
+ * types[node].resolved = true;
+ * ```
+ */
+template <typename T>
+class NodeMap {
+public:
+    /** Construct a map holding `value` for every node of `tree`. */
+    explicit NodeMap(const Tree& tree, const T& value = T())
+        : m_index(tree.nodeIndex()),
+          m_values(m_index->size(), value) { }
+
+    /** Number of nodes in the map. */
+    size_t size() const { return m_values.size(); }
+    /** The shared index of the tree. */
+    const NodeIndex& index() const { return *m_index; }
+
+    /**
+     * @brief Value for a node.
+     * @throws std::out_of_range if the node is not part of the tree.
+     */
+    T& operator[](const Node& node) { return m_values[checkedIndex(node)]; }
+    /** Value for a node. */
+    const T& operator[](const Node& node) const { return m_values[checkedIndex(node)]; }
+
+    /** Value for a node, or `nullptr` if it is not part of the tree. */
+    T* find(const Node& node) {
+        const size_t i = m_index->indexOf(node);
+        return i == NodeIndex::npos ? nullptr : &m_values[i];
+    }
+    /** Value for a node, or `nullptr` if it is not part of the tree. */
+    const T* find(const Node& node) const {
+        const size_t i = m_index->indexOf(node);
+        return i == NodeIndex::npos ? nullptr : &m_values[i];
+    }
+
+    /** Value at a pre-order position. */
+    T& at(size_t index) { return m_values.at(index); }
+    /** Value at a pre-order position. */
+    const T& at(size_t index) const { return m_values.at(index); }
+
+    /** Values, in pre-order. */
+    auto begin() { return m_values.begin(); }
+    /** Values, in pre-order. */
+    auto end() { return m_values.end(); }
+    /** Values, in pre-order. */
+    auto begin() const { return m_values.begin(); }
+    /** Values, in pre-order. */
+    auto end() const { return m_values.end(); }
+private:
+    size_t checkedIndex(const Node& node) const {
+        const size_t i = m_index->indexOf(node);
+        if (i == NodeIndex::npos) {
+            throw std::out_of_range("Node does not belong to this tree");
+        }
+        return i;
+    }
+
+    std::shared_ptr<const NodeIndex> m_index;
+    std::vector<T> m_values;
+};
+
+}
@@ -0,0 +1,102 @@
+/**
+ * @file tree_sitter/cpp/parallel.h
+ * @brief Multi-threaded traversal of a single tree.
+ */
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "tree_sitter/api.h"
+#include "tree_sitter/cxx/point.h"
+
+namespace TreeSitter {
+
+class Node;
+class SymbolSet;
+
+/**
+ * @brief Walks one large tree on several threads.
+ *
+ * The tree is split into partitions: whole subtrees no larger than a
+ * byte budget, plus the ancestors that had to be split to get there.
+ * Partitions are listed in pre-order, so results collected per
+ * partition can be concatenated back into document order.
+ *
+ * ```c++
+ * ParallelTraversal walk(tree.rootNode());
+ * auto calls = walk.descendantsOfType(lang.symbolsForTypes({ "call_expression" }));
+ * ```
+ *
+ * @note Each thread walks its own copy of the tree, made with
+ * `ts_tree_copy()`, as tree-sitter requires for using a tree on
+ * several threads. The tree must not be edited until the walk has
+ * finished.
+ */
+class ParallelTraversal {
+public:
+    /**
+     * @brief Options for parallel traversal.
+     */
+    struct Options {
+        /** Number of threads (0 = one per hardware thread). */
+        unsigned threads;
+        /** Smallest subtree, in bytes, worth its own partition (0 = 64 KiB). */
+        Index minPartitionSize;
+    };
+
+    /**
+     * @brief Visitor callback.
+     *
+     * @param node Visited node.
+     * @param partition Index of the partition being walked.
+     *   Nodes with a lower partition index come first in the document.
+     */
+    using Visitor = std::function<void (const Node& node, size_t partition)>;
+
+    /** Construct a new ParallelTraversal object. */
+    ParallelTraversal(const Node& root, Options options = { 0, 0 });
+    /** @internal Copy constructor. */
+    ParallelTraversal(const ParallelTraversal& traversal);
+    /** @internal Copy assignment constructor. */
+    ParallelTraversal& operator=(const ParallelTraversal& traversal);
+    /** Destructor. */
+    ~ParallelTraversal();
+
+    /** Number of threads used. */
+    unsigned threadCount() const;
+    /** Number of partitions the tree was split into. */
+    size_t partitionCount() const;
+
+    /**
+     * @brief Visit every node concurrently.
+     *
+     * Nodes of one partition are visited in pre-order by a single
+     * thread; partitions run concurrently. Exceptions thrown by the
+     * visitor are rethrown once every thread has stopped.
+     *
+     * The visited nodes belong to the thread's copy of the tree: they
+     * are only valid during the call, and have the same id() as the
+     * nodes of the tree but do not compare equal to them.
+     */
+    void visit(const Visitor& visitor, bool namedOnly = false) const;
+
+    /**
+     * @brief Collect matching nodes, in document order.
+     *
+     * The predicate is called concurrently from several threads, with
+     * nodes of their copies as in visit(). The returned nodes belong to
+     * the tree.
+     */
+    std::vector<Node> collect(const std::function<bool (const Node& node)>& predicate,
+        bool namedOnly = false) const;
+
+    /** Returns a list of descendants, in document order. */
+    std::vector<Node> descendantsOfType(const SymbolSet& symbols) const;
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+
+}
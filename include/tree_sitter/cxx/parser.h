@@ -7,6 +7,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 #include "tree_sitter/cxx/point.h"
 #include "tree_sitter/cxx/lang.h"
 
@@ -72,6 +73,20 @@ public:
     /** Set the current language. */
     void setLanguage(Language language);
 
+    /** The ranges of the input that are parsed; empty for the whole input. */
+    std::vector<Range> includedRanges() const;
+    /**
+     * @brief Parse only some ranges of the input.
+     *
+     * Used for languages embedded in another one, such as a script in
+     * an HTML document: the tree spans the whole input, but only the
+     * text inside `ranges` is parsed. An empty list restores the
+     * whole input.
+     *
+     * @throws std::invalid_argument If the ranges overlap or are not in order.
+     */
+    void setIncludedRanges(const std::vector<Range>& ranges);
+
     /** The current logger. */
     Logger logger() const;
     /** Set the current logger. */
@@ -25,6 +25,21 @@ using Point = TSPoint;
  */
 using Range = TSRange;
 
+/**
+ * Units for counting columns.
+ *
+ * Tree-sitter counts columns in bytes of UTF-8. Language servers
+ * usually count UTF-16 code units instead.
+ */
+enum class ColumnUnit {
+    /** UTF-8 bytes. */
+    Bytes,
+    /** UTF-16 code units. */
+    UTF16,
+    /** Unicode code points. */
+    CodePoints
+};
+
 /**
  * Represents edits made to a source code tree.
  */
@@ -0,0 +1,66 @@
+/**
+ * @file tree_sitter/cpp/positions.h
+ * @brief Prebuilt position to node lookups.
+ */
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "tree_sitter/api.h"
+#include "tree_sitter/cxx/node.h"
+#include "tree_sitter/cxx/point.h"
+
+namespace TreeSitter {
+
+class Tree;
+
+/**
+ * @brief Finds the smallest node at a position without descending the tree.
+ *
+ * Built once per tree by Tree.positionIndex(). The source is split at
+ * every node boundary into segments, each remembering the smallest node
+ * and the smallest named node covering it, so a lookup is one binary
+ * search. Results match Node.descendantForPosition() and
+ * Node.namedDescendantForPosition() on the root node: a node contains
+ * the positions from its start up to, but excluding, its end, and empty
+ * nodes are never returned.
+ *
+ * The batched lookups take positions in ascending order and find all of
+ * them in a single sweep over the segments.
+ */
+class PositionIndex {
+public:
+    /** @internal Created by Tree. */
+    PositionIndex(const Tree* tree);
+    /** @internal Copy constructor. */
+    PositionIndex(const PositionIndex& index);
+    /** @internal Copy assignment constructor. */
+    PositionIndex& operator=(const PositionIndex& index);
+    /** Destructor. */
+    ~PositionIndex();
+
+    /** Smallest node containing a position. */
+    Node descendantForPosition(Point position) const;
+    /** Smallest named node containing a position. */
+    Node namedDescendantForPosition(Point position) const;
+
+    /**
+     * @brief Smallest node containing each position.
+     *
+     * Sorted positions are resolved in one sweep; out of order ones fall
+     * back to a binary search.
+     */
+    std::vector<Node> descendantsForPositions(const std::vector<Point>& positions) const;
+    /** Smallest named node containing each position. See descendantsForPositions(). */
+    std::vector<Node> namedDescendantsForPositions(const std::vector<Point>& positions) const;
+
+    /** Number of segments the source was split into. */
+    size_t segmentCount() const;
+    /** Approximate heap memory used by this index, in bytes. */
+    size_t memoryUsage() const;
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+
+}
@@ -4,19 +4,49 @@
  */
 #pragma once
 
+#include <cstddef>
+#include <functional>
+#include <iterator>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
 #include "tree_sitter/api.h"
+#include "tree_sitter/cxx/lang.h"
 #include "tree_sitter/cxx/point.h"
 #include "tree_sitter/cxx/node.h"
 
 namespace TreeSitter {
 
+namespace Internal {
+struct CompiledQuery;
+}
+
 /**
  * @brief A class to query souce code.
+ *
+ * A Query is immutable once compiled. Copies share the compiled query
+ * and its predicates, and the const methods may be called from several
+ * threads at once: every run gets its own cursor. Use a QueryCursor to
+ * reuse one cursor across runs, restrict the range or read whether the
+ * match limit was hit. See also QueryCache.
+ *
+ * These predicates are checked while matching; matches that fail them
+ * are never reported:
+ *
+ * - `#eq?`, `#not-eq?`: text equal to a string or another capture.
+ * - `#match?`, `#not-match?`: the regex is found in the text.
+ * - `#any-of?`, `#not-any-of?`: text is one of the strings.
+ * - `#any-eq?`, `#any-not-eq?`, `#any-match?`, `#any-not-match?`:
+ *   like the above, for captures of several nodes.
+ * - Predicates added with registerPredicate().
+ *
+ * The plain forms must hold for every node of a capture, the `any-`
+ * forms for at least one. Other predicates are returned by
+ * predicatesForPattern().
  */
 class Query {
 public:
@@ -32,8 +62,10 @@ public:
      * @brief A query result.
      */
     struct Capture {
-        /** Result name. */
-        std::string name;
+        /** Index of the capture name; see captureName(). */
+        uint32_t index;
+        /** Capture name, interned: valid for the lifetime of the program. */
+        std::string_view name;
         /** Captured node. */
         Node node;
     };
@@ -52,9 +84,9 @@ public:
      * @brief A source code type.
      */
     struct Operand {
-        /** Operand name. */
+        /** Capture name, or the value of a string. */
         std::string name;
-        /** Operand type. */
+        /** Operand type: `capture` or `string`. */
         std::string type;
     };
 
@@ -71,19 +103,81 @@ public:
     /** @private Query map */
     using Properties = std::unordered_map<std::string, std::string>;
 
-    /** @internal Function for testing results. */
-    using TextPredicate = std::function<bool (std::vector<Capture> captures)>;
+    /**
+     * @brief An argument of a custom predicate.
+     */
+    struct Argument {
+        /** `true` for a capture, `false` for a string. */
+        bool isCapture;
+        /** Capture index, for captures. */
+        uint32_t capture;
+        /** Capture name or string value. Valid while the query is alive. */
+        std::string_view value;
+    };
+
+    /**
+     * @brief The captures of a match, as seen by a custom predicate.
+     *
+     * Gives access to the raw captures and their text without creating
+     * Node objects or copying text.
+     */
+    class MatchView {
+    public:
+        /** @internal Created while matching. */
+        MatchView(const Tree* tree, uint32_t pattern, const TSQueryCapture* captures, uint32_t count)
+            : m_tree(tree), m_pattern(pattern), m_captures(captures), m_count(count) { }
+
+        /** The tree being queried. */
+        const Tree* tree() const { return m_tree; }
+        /** Index of the matched pattern. */
+        uint32_t pattern() const { return m_pattern; }
+        /** Number of captured nodes. */
+        uint32_t size() const { return m_count; }
+        /** Capture index of the `i`-th captured node. */
+        uint32_t captureIndex(uint32_t i) const { return m_captures[i].index; }
+        /** The `i`-th captured node. */
+        TSNode node(uint32_t i) const { return m_captures[i].node; }
+        /** Text of the `i`-th captured node. */
+        std::string_view text(uint32_t i) const;
+        /** Position of the first node of capture `capture` at or after `from`, or size(). */
+        uint32_t find(uint32_t capture, uint32_t from = 0) const;
+    private:
+        const Tree* m_tree;
+        uint32_t m_pattern;
+        const TSQueryCapture* m_captures;
+        uint32_t m_count;
+    };
+
+    /**
+     * @brief A custom predicate.
+     *
+     * Called with a candidate match and the arguments written after the
+     * predicate name; returns `false` to drop the match. Called from
+     * whatever thread runs the query.
+     */
+    using Predicate = std::function<bool (const MatchView& match, const std::vector<Argument>& arguments)>;
+
+    /**
+     * @brief Register a custom predicate.
+     *
+     * ```c++
+     * Query::registerPredicate("is-upper?", [](const Query::MatchView& match, const auto& args) {
+     *     for (uint32_t i = match.find(args[0].capture); i < match.size(); i = match.find(args[0].capture, i + 1)) {
+     *         if (!isUpper(match.text(i))) return false;
+     *     }
+     *     return true;
+     * });
+     * ```
+     *
+     * `name` is the predicate as written in queries, without the `#`.
+     * Queries compiled afterwards evaluate it while matching; queries
+     * compiled before keep reporting it in predicatesForPattern().
+     * QueryCache compiles its queries again after a registration.
+     */
+    static void registerPredicate(const std::string& name, Predicate predicate);
 
     /** @internal Create a new Query. */
-    Query(
-        TSQuery* query,
-        std::vector<std::string> captureNames,
-        std::vector<std::vector<TextPredicate>> textPredicates,
-        std::vector<std::vector<PredicateResult>> predicates,
-        std::vector<Properties> setProperties,
-        std::vector<Properties> assertedProperties,
-        std::vector<Properties> refutedProperties
-    );
+    explicit Query(std::shared_ptr<const Internal::CompiledQuery> compiled);
     /** @internal Copy constructor. */
     Query(const Query& query);
     /** @internal Copy assignment constructor. */
@@ -98,13 +192,39 @@ public:
      */
     std::vector<std::string> captureNames() const;
 
+    /** The language the query was compiled for. */
+    Language language() const;
+    /** The source the query was compiled from. */
+    const std::string& source() const;
+    /** Number of patterns. */
+    uint32_t patternCount() const;
+
+    /** Number of capture names. */
+    uint32_t captureCount() const;
+    /** The name of capture `index`, or an empty string. */
+    std::string_view captureName(uint32_t index) const;
+    /**
+     * @brief Look up a capture by name.
+     *
+     * Resolve capture names once, then compare Capture.index while
+     * consuming results instead of comparing names.
+     */
+    std::optional<uint32_t> captureIndex(std::string_view name) const;
+
     /**
      * @brief Get a list of predicates.
      * 
      * @param patternIndex Pattern to use.
      * @return Predicates list.
      */
-    std::vector<PredicateResult> predicatesForPattern(int patternIndex);
+    std::vector<PredicateResult> predicatesForPattern(int patternIndex) const;
+
+    /** Properties set with `#set!` in a pattern. */
+    const Properties& setProperties(uint32_t pattern) const;
+    /** Properties asserted with `#is?` in a pattern. */
+    const Properties& assertedProperties(uint32_t pattern) const;
+    /** Properties refuted with `#is-not?` in a pattern. */
+    const Properties& refutedProperties(uint32_t pattern) const;
 
     /*
      * TODO:
@@ -115,8 +235,173 @@ public:
     /**
      * @brief Find matches for a query.
      */
-    std::vector<Match> matches(Node node, Point startPosition = { 0, 0 }, Point endPosition = { 0, 0 }, Options options = { 0 });
-    std::vector<Capture> captures(Node node, Point startPosition = { 0, 0 }, Point endPosition = { 0, 0 }, Options options = { 0 });
+    std::vector<Match> matches(Node node, Point startPosition = { 0, 0 }, Point endPosition = { 0, 0 }, Options options = { 0 }) const;
+    std::vector<Capture> captures(Node node, Point startPosition = { 0, 0 }, Point endPosition = { 0, 0 }, Options options = { 0 }) const;
+
+private:
+    friend class QueryCursor;
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+
+class QueryCursor;
+
+/**
+ * @brief Results of a query run, pulled one at a time.
+ *
+ * Created by QueryCursor.eachMatch() and QueryCursor.eachCapture().
+ * Every step pulls from the cursor and checks the predicates, so
+ * memory use does not grow with the number of results, and breaking
+ * out of the loop stops the run.
+ *
+ * @note This is a single-pass input range. The current value belongs
+ * to the cursor and is overwritten by the next step; copy it to keep it.
+ */
+template <typename T, const T* (QueryCursor::*Next)()>
+class QueryResults {
+public:
+    /** Marks the end of the results. */
+    struct sentinel {};
+
+    /**
+     * @brief Input iterator over the results.
+     */
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        iterator() = default;
+        /** @internal Created by QueryResults. */
+        explicit iterator(QueryResults* results) : m_results(results) {}
+
+        /** The current result. */
+        const T& operator*() const { return *m_results->m_current; }
+        /** The current result. */
+        const T* operator->() const { return m_results->m_current; }
+        /** Move to the next result. */
+        iterator& operator++() { m_results->next(); return *this; }
+        /** Move to the next result. */
+        void operator++(int) { m_results->next(); }
+
+        friend bool operator==(const iterator& it, sentinel) { return it.done(); }
+        friend bool operator==(sentinel, const iterator& it) { return it.done(); }
+        friend bool operator!=(const iterator& it, sentinel) { return !it.done(); }
+        friend bool operator!=(sentinel, const iterator& it) { return !it.done(); }
+    private:
+        bool done() const { return m_results == nullptr || m_results->m_current == nullptr; }
+
+        QueryResults* m_results = nullptr;
+    };
+
+    /** @internal Created by QueryCursor. */
+    explicit QueryResults(QueryCursor* cursor) : m_cursor(cursor) {}
+
+    /** Pull the first result. */
+    iterator begin() { next(); return iterator(this); }
+    /** End of the results. */
+    sentinel end() const { return {}; }
+private:
+    void next() { m_current = (m_cursor->*Next)(); }
+
+    QueryCursor* m_cursor;
+    const T* m_current = nullptr;
+};
+
+/**
+ * @brief The state of one query run.
+ *
+ * A cursor runs any Query; it is not tied to one. Keep one per thread
+ * and reuse it to avoid setting up a new cursor for every run:
+ *
+ * ```c++
+ * QueryCursor cursor;
+ * for (const Tree& tree : trees) {
+ *     for (const auto& match : cursor.matches(query, tree.rootNode())) { ... }
+ * }
+ * ```
+ *
+ * Results can also be pulled one at a time, without collecting them:
+ *
+ * ```c++
+ * const uint32_t definition = query.captureIndex("definition").value();
+ * for (const Query::Capture& capture : cursor.eachCapture(query, root)) {
+ *     if (capture.index == definition) {
+ *         break;
+ *     }
+ * }
+ * ```
+ *
+ * The cursor state, with its TSQueryCursor and match buffer, comes
+ * from a small per-thread pool and goes back to it on destruction, so
+ * creating a cursor does not allocate once the pool is warm.
+ * Query.matches() and Query.captures() borrow one the same way. A
+ * cursor must only be used by one thread at a time.
+ */
+class QueryCursor {
+public:
+    /** Construct a new QueryCursor. */
+    QueryCursor();
+    QueryCursor(const QueryCursor&) = delete;
+    QueryCursor& operator=(const QueryCursor&) = delete;
+    /** Destructor. */
+    ~QueryCursor();
+
+    /** Max number of in-progress matches (0 = no limit). */
+    void setMatchLimit(uint32_t limit);
+    /** Only report matches intersecting this range (end 0 = no limit). */
+    void setByteRange(Index start, Index end);
+    /** Only report matches intersecting this range (end {0, 0} = no limit). */
+    void setPointRange(Point start, Point end);
+    /** `true` if the last run had to drop matches because of the match limit. */
+    bool didExceedMatchLimit() const;
+
+    /**
+     * @brief Start running `query` on `node`.
+     *
+     * Results are then pulled with nextMatch() or nextCapture(). The
+     * query and the tree must stay alive until the run is over.
+     */
+    void exec(const Query& query, const Node& node);
+    /**
+     * @brief The next match that satisfies the predicates.
+     *
+     * @return `nullptr` once the run is over. The match is owned by
+     *   the cursor and valid until the next call.
+     */
+    const Query::Match* nextMatch();
+    /**
+     * @brief The next capture, in document order, whose match satisfies the predicates.
+     *
+     * @return `nullptr` once the run is over. The capture is owned by
+     *   the cursor and valid until the next call.
+     */
+    const Query::Capture* nextCapture();
+    /**
+     * @brief The current match.
+     *
+     * After nextCapture(), the match the capture belongs to. Valid until
+     * the next call to nextMatch() or nextCapture().
+     */
+    const Query::Match& currentMatch() const;
+
+    /** Lazily pulled matches. */
+    using MatchRange = QueryResults<Query::Match, &QueryCursor::nextMatch>;
+    /** Lazily pulled captures. */
+    using CaptureRange = QueryResults<Query::Capture, &QueryCursor::nextCapture>;
+
+    /** Run `query` on `node` and iterate over the matches. */
+    MatchRange eachMatch(const Query& query, const Node& node);
+    /** Run `query` on `node` and iterate over the captures, in document order. */
+    CaptureRange eachCapture(const Query& query, const Node& node);
+
+    /** Run `query` on `node` and collect the matches. */
+    std::vector<Query::Match> matches(const Query& query, const Node& node);
+    /** Run `query` on `node` and collect the captures, in document order. */
+    std::vector<Query::Capture> captures(const Query& query, const Node& node);
 
 private:
     struct Private;
@@ -0,0 +1,77 @@
+/**
+ * @file tree_sitter/cpp/querycache.h
+ * @brief Cache of compiled queries.
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "tree_sitter/cxx/lang.h"
+#include "tree_sitter/cxx/query.h"
+
+namespace TreeSitter {
+
+/**
+ * @brief Compiles each query once and hands out copies.
+ *
+ * Queries are keyed by language and query source. A hit returns a copy
+ * of the cached Query, which shares the compiled query and predicates.
+ * Queries cached before a Query.registerPredicate() call are not
+ * returned anymore, so the new predicate is always evaluated.
+ * Once the cache holds `capacity` queries, the least recently used one
+ * is dropped; copies handed out earlier stay valid.
+ *
+ * All methods are thread-safe. Compilation happens outside the lock, so
+ * two threads missing on the same query at once may both compile it.
+ *
+ * ```c++
+ * Query query = QueryCache::global().get(lang, "(identifier) @name");
+ * ```
+ */
+class QueryCache {
+public:
+    /** Cache counters. */
+    struct Stats {
+        /** Lookups answered from the cache. */
+        uint64_t hits;
+        /** Lookups that compiled a query. */
+        uint64_t misses;
+        /** Queries dropped to stay within the capacity. */
+        uint64_t evictions;
+        /** Queries currently cached. */
+        size_t size;
+    };
+
+    /** Construct a cache holding up to `capacity` queries. */
+    explicit QueryCache(size_t capacity = 64);
+    QueryCache(const QueryCache&) = delete;
+    QueryCache& operator=(const QueryCache&) = delete;
+    /** Destructor. */
+    ~QueryCache();
+
+    /** A process-wide cache. */
+    static QueryCache& global();
+
+    /**
+     * @brief The compiled query for `source`.
+     *
+     * Compiles it with Language.query() on a miss. Errors are thrown
+     * like Language.query() does and are not cached.
+     */
+    Query get(const Language& lang, const std::string& source);
+
+    /** Current counters. */
+    Stats stats() const;
+    /** Maximum number of cached queries. */
+    size_t capacity() const;
+    /** Change the capacity, evicting queries if needed. */
+    void setCapacity(size_t capacity);
+    /** Drop every cached query. Counters are kept. */
+    void clear();
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+
+}
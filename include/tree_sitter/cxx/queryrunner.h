@@ -0,0 +1,148 @@
+/**
+ * @file tree_sitter/cpp/queryrunner.h
+ * @brief Multi-threaded queries over many trees.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "tree_sitter/cxx/point.h"
+#include "tree_sitter/cxx/query.h"
+
+namespace TreeSitter {
+
+class Tree;
+
+/**
+ * @brief Runs one query over a corpus on several threads.
+ *
+ * Inputs are trees, or files that are read and parsed with the
+ * language of the query while running. Each thread takes the next
+ * input, and has its own QueryCursor and Parser.
+ *
+ * ```c++
+ * QueryRunner runner(QueryCache::global().get(lang, "(call_expression) @call"));
+ * auto counts = runner.countCaptures(QueryRunner::fromFiles(paths));
+ * ```
+ *
+ * Exceptions thrown while running, by a visitor or because a file
+ * could not be read, are rethrown once every thread has stopped.
+ */
+class QueryRunner {
+public:
+    /**
+     * @brief Options for running queries.
+     */
+    struct Options {
+        /** Number of threads (0 = one per hardware thread). */
+        unsigned threads;
+    };
+
+    /**
+     * @brief A tree or a file to query.
+     */
+    struct Input {
+        /** A parsed tree, or `nullptr` to parse `path`. */
+        const Tree* tree;
+        /** The file to parse if there is no tree. */
+        std::string path;
+    };
+
+    /**
+     * @brief A capture that outlives its tree.
+     *
+     * Get its name with Query.captureName(index).
+     */
+    struct Capture {
+        /** Index of the input. */
+        size_t input;
+        /** Index of the matched pattern. */
+        uint32_t pattern;
+        /** Index of the capture name. */
+        uint32_t index;
+        /** Starting offset. */
+        Index startIndex;
+        /** Ending offset. */
+        Index endIndex;
+        /** Starting position. */
+        Point startPosition;
+        /** Ending position. */
+        Point endPosition;
+    };
+
+    /**
+     * @brief Match callback.
+     *
+     * @param input Index of the input.
+     * @param match The match; only valid during the call.
+     * @param thread Index of the calling thread, below threadCount().
+     */
+    using Visitor = std::function<void (size_t input, const Query::Match& match, unsigned thread)>;
+
+    /** Inputs for already parsed trees. */
+    static std::vector<Input> fromTrees(const std::vector<Tree>& trees);
+    /** Inputs for files to parse. */
+    static std::vector<Input> fromFiles(const std::vector<std::string>& paths);
+
+    /** Construct a new QueryRunner. */
+    explicit QueryRunner(const Query& query, Options options = { 0 });
+    /** @internal Copy constructor. */
+    QueryRunner(const QueryRunner& runner);
+    /** @internal Copy assignment constructor. */
+    QueryRunner& operator=(const QueryRunner& runner);
+    /** Destructor. */
+    ~QueryRunner();
+
+    /** Number of threads used. */
+    unsigned threadCount() const;
+
+    /**
+     * @brief Visit every match of every input.
+     *
+     * The visitor is called concurrently; the matches of one input are
+     * visited in order by a single thread.
+     */
+    void visit(const std::vector<Input>& inputs, const Visitor& visitor) const;
+
+    /**
+     * @brief Collect every capture.
+     *
+     * Sorted by input, then in document order, whatever the thread
+     * count and scheduling.
+     */
+    std::vector<Capture> captures(const std::vector<Input>& inputs) const;
+
+    /** Number of captures, per capture index. */
+    std::vector<uint64_t> countCaptures(const std::vector<Input>& inputs) const;
+
+    /**
+     * @brief Fold every match into a value.
+     *
+     * Each thread folds its matches into its own copy of `init` with
+     * `map(T& value, size_t input, const Query::Match& match)`; the
+     * copies are then combined with `merge(T& value, T&& other)`, in
+     * thread order. `init` must be neutral for `merge`, and `merge`
+     * should not depend on the order of the matches, like a count or
+     * a sum.
+     */
+    template <typename T, typename Map, typename Merge>
+    T reduce(const std::vector<Input>& inputs, T init, Map map, Merge merge) const {
+        std::vector<T> partial(threadCount(), init);
+        visit(inputs, [&partial, &map](size_t input, const Query::Match& match, unsigned thread) {
+            map(partial[thread], input, match);
+        });
+        for (T& value : partial) {
+            merge(init, std::move(value));
+        }
+        return init;
+    }
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+
+}
@@ -0,0 +1,94 @@
+/**
+ * @file tree_sitter/cpp/serializer.h
+ * @brief Streaming tree serializers.
+ */
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include "tree_sitter/api.h"
+
+namespace TreeSitter {
+
+class Node;
+
+/**
+ * @brief Writes an AST as an S-expression, JSON or XML.
+ *
+ * The tree is walked with a cursor and written in small chunks,
+ * so the whole document is never held in memory at once.
+ *
+ * ```c++
+ * Serializer serializer(Serializer::JSON);
+ * serializer.write(tree.rootNode(), std::cout);
+ * ```
+ */
+class Serializer {
+public:
+    /** Output formats. */
+    enum Format {
+        SExpression,
+        JSON,
+        XML
+    };
+
+    /**
+     * @brief Serialization options.
+     */
+    struct Options {
+        /** Output format. */
+        Format format;
+        /** Include the source text of leaf nodes. */
+        bool includeText;
+        /** Include start/end positions and offsets. */
+        bool includePositions;
+        /** Include the field name of each child. */
+        bool includeFieldNames;
+        /** Include anonymous nodes such as punctuation. */
+        bool includeAnonymous;
+    };
+
+    /**
+     * @brief Output callback.
+     *
+     * Receives consecutive chunks of the serialized tree.
+     */
+    using Sink = std::function<void (const char* data, size_t length)>;
+
+    /**
+     * @brief Construct a new Serializer object.
+     *
+     * Field names are included, everything else is left out.
+     */
+    Serializer(Format format = SExpression);
+
+    /** Construct a new Serializer object. */
+    Serializer(Options options);
+    /** @internal Copy constructor. */
+    Serializer(const Serializer& serializer);
+    /** @internal Copy assignment constructor. */
+    Serializer& operator=(const Serializer& serializer);
+    /** Destructor. */
+    ~Serializer();
+
+    /** The current options. */
+    Options options() const;
+    /** Set the current options. */
+    void setOptions(Options options);
+
+    /** Serialize a node and its descendants to a stream. */
+    void write(const Node& node, std::ostream& out);
+    /** Serialize a node and its descendants to a sink. */
+    void write(const Node& node, Sink sink);
+
+    /** Serialize a node and its descendants to a string. */
+    std::string toString(const Node& node);
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+
+}
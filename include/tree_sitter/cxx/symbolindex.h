@@ -0,0 +1,115 @@
+/**
+ * @file tree_sitter/cpp/symbolindex.h
+ * @brief Persistent index of tags.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "tree_sitter/cxx/tagger.h"
+
+namespace TreeSitter {
+
+/**
+ * @brief The tags of many files, looked up by name.
+ *
+ * Files are added and replaced one at a time, along with a stamp such
+ * as their modification time or a hash of their content, so only the
+ * files whose stamp changed need to be tagged again:
+ *
+ * ```c++
+ * SymbolIndex index = SymbolIndex::load("symbols.idx");
+ * if (index.stamp(path) != mtime) {
+ *     index.update(path, mtime, tagger.tags(parser.parse(content)));
+ * }
+ * index.save("symbols.idx");
+ * auto symbols = index.findPrefix("parse");
+ * ```
+ *
+ * Names are kept sorted, so exact and prefix lookups take logarithmic
+ * time plus the number of results. The index is saved in a compact
+ * binary format, independent of the platform.
+ */
+class SymbolIndex {
+public:
+    /**
+     * @brief A tag found in an indexed file.
+     */
+    struct Symbol {
+        /** The file the tag was found in. */
+        std::string path;
+        /** The tag. */
+        Tagger::Tag tag;
+    };
+
+    /** Construct an empty index. */
+    SymbolIndex();
+    /** @internal Copy constructor. */
+    SymbolIndex(const SymbolIndex& index);
+    /** @internal Copy assignment constructor. */
+    SymbolIndex& operator=(const SymbolIndex& index);
+    /** Destructor. */
+    ~SymbolIndex();
+
+    /**
+     * @brief Read an index written by save().
+     *
+     * @throws std::runtime_error If the data is not a valid index.
+     */
+    static SymbolIndex load(std::istream& in);
+    /**
+     * @brief Read an index file; an empty index if the file does not exist.
+     *
+     * @throws std::runtime_error If the file is not a valid index.
+     */
+    static SymbolIndex load(const std::string& path);
+
+    /** Write the index to a stream. */
+    void save(std::ostream& out) const;
+    /**
+     * @brief Write the index to a file.
+     *
+     * The file is replaced at once, so readers never see a partial index.
+     *
+     * @throws std::runtime_error If the file cannot be written.
+     */
+    void save(const std::string& path) const;
+
+    /** Number of indexed files. */
+    size_t fileCount() const;
+    /** Number of indexed tags. */
+    size_t size() const;
+    /** The indexed files, sorted. */
+    std::vector<std::string> files() const;
+    /** The stamp of a file, or nothing if it is not indexed. */
+    std::optional<uint64_t> stamp(const std::string& path) const;
+
+    /** Replace the tags of a file. */
+    void update(const std::string& path, uint64_t stamp, std::vector<Tagger::Tag> tags);
+    /** Remove a file; returns `false` if it was not indexed. */
+    bool remove(const std::string& path);
+    /** Remove every file. */
+    void clear();
+
+    /** Every tag named `name`. */
+    std::vector<Symbol> find(std::string_view name) const;
+    /**
+     * @brief Every tag whose name starts with `prefix`, sorted by name.
+     *
+     * @param prefix Start of the names.
+     * @param limit Maximum number of results (0 = no limit).
+     */
+    std::vector<Symbol> findPrefix(std::string_view prefix, size_t limit = 0) const;
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+
+}
@@ -0,0 +1,81 @@
+/**
+ * @file tree_sitter/cpp/tagger.h
+ * @brief Definitions and references of a tree.
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "tree_sitter/cxx/point.h"
+#include "tree_sitter/cxx/query.h"
+
+namespace TreeSitter {
+
+class Tree;
+
+/**
+ * @brief Extracts tags with a `tags.scm` query.
+ *
+ * Follows the conventions of tree-sitter-tags. Each pattern captures:
+ *
+ * - `@definition.<kind>` or `@reference.<kind>`: the whole definition
+ *   or reference, such as `@definition.function`.
+ * - `@name`: its name.
+ * - `@doc` (optional): its documentation comments.
+ *
+ * `#strip! @doc "regex"` removes the matches of the regex from each
+ * comment, and `#select-adjacent! @doc @definition.function` keeps only
+ * the comments directly above the definition. Patterns with an
+ * `@ignore` capture are skipped.
+ *
+ * ```c++
+ * Tagger tagger(lang.query(tagsScm));
+ * for (const Tagger::Tag& tag : tagger.tags(tree)) { ... }
+ * ```
+ */
+class Tagger {
+public:
+    /**
+     * @brief A definition or a reference; outlives its tree.
+     */
+    struct Tag {
+        /** Text of the name. */
+        std::string name;
+        /** Kind, such as `function` or `call`. */
+        std::string kind;
+        /** `true` for a definition, `false` for a reference. */
+        bool definition;
+        /** The whole definition or reference. */
+        Range range;
+        /** The name. */
+        Range nameRange;
+        /** Documentation comments, one per line; empty if there are none. */
+        std::string docs;
+    };
+
+    /** Construct a new Tagger. */
+    explicit Tagger(const Query& query);
+    /** @internal Copy constructor. */
+    Tagger(const Tagger& tagger);
+    /** @internal Copy assignment constructor. */
+    Tagger& operator=(const Tagger& tagger);
+    /** Destructor. */
+    ~Tagger();
+
+    /** The tags query. */
+    const Query& query() const;
+
+    /**
+     * @brief Every tag of a tree, sorted by the position of its name.
+     *
+     * A name captured by several patterns is tagged once, by the first
+     * match that captures it.
+     */
+    std::vector<Tag> tags(const Tree& tree) const;
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+
+}
@@ -0,0 +1,154 @@
+/**
+ * @file tree_sitter/cpp/traversal.h
+ * @brief Descendant traversal.
+ */
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include "tree_sitter/api.h"
+
+namespace TreeSitter {
+
+class Node;
+class Tree;
+
+/**
+ * @brief Walks every descendant of a node.
+ *
+ * Created by Node.descendants(). The walk is driven by a tree cursor
+ * borrowed from a per-thread pool, so it never recurses and does not
+ * allocate for pre-order and post-order walks. Level-order walks keep
+ * a queue of pending nodes.
+ *
+ * ```c++
+ * auto walk = node.descendants(Traversal::PreOrder, true);
+ * for (auto it = walk.begin(); it != walk.end(); ++it) {
+ *     if ((*it).type() == "function_definition") {
+ *         it.skipSubtree();
+ *     }
+ * }
+ * ```
+ *
+ * @note This is a single-pass input range; every iterator shares the
+ * state of the traversal it came from.
+ */
+class Traversal {
+public:
+    /** Visiting orders. */
+    enum Order {
+        /** Parents before their children. */
+        PreOrder,
+        /** Children before their parents. */
+        PostOrder,
+        /** Breadth-first, one depth level at a time. */
+        LevelOrder
+    };
+
+    /** Marks the end of the traversal. */
+    struct sentinel {};
+
+    /**
+     * @brief Input iterator over the descendants.
+     */
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Node;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Node;
+
+        iterator() = default;
+        /** @internal Created by Traversal. */
+        explicit iterator(Traversal* traversal) : m_traversal(traversal) {}
+
+        /** The current node. */
+        Node operator*() const;
+        /** The current node as a raw TSNode. */
+        TSNode node() const { return m_traversal->current(); }
+        /** Depth of the current node, relative to the starting node. */
+        uint32_t depth() const { return m_traversal->depth(); }
+        /** Do not visit the descendants of the current node. */
+        void skipSubtree() { m_traversal->skipSubtree(); }
+        /** Move to the next node. */
+        iterator& operator++() { m_traversal->next(); return *this; }
+        /** Move to the next node. */
+        void operator++(int) { m_traversal->next(); }
+
+        friend bool operator==(const iterator& it, sentinel) { return it.done(); }
+        friend bool operator==(sentinel, const iterator& it) { return it.done(); }
+        friend bool operator!=(const iterator& it, sentinel) { return !it.done(); }
+        friend bool operator!=(sentinel, const iterator& it) { return !it.done(); }
+    private:
+        bool done() const { return m_traversal == nullptr || m_traversal->done(); }
+
+        Traversal* m_traversal = nullptr;
+    };
+
+    /** @internal Created by Node. */
+    Traversal(const Tree* tree, TSNode root, Order order, bool namedOnly);
+    /** @internal Move constructor. */
+    Traversal(Traversal&& traversal) noexcept;
+    Traversal(const Traversal&) = delete;
+    Traversal& operator=(const Traversal&) = delete;
+    /** Destructor. */
+    ~Traversal();
+
+    /** Start (or restart) the traversal. */
+    iterator begin();
+    /** End of the traversal. */
+    sentinel end() const { return {}; }
+
+    /**
+     * @brief Move to the next node.
+     *
+     * Can be used instead of iterators. The first call starts the walk.
+     *
+     * @return `false` once every node has been visited.
+     */
+    bool next();
+    /** Returns `true` once every node has been visited. */
+    bool done() const { return m_done; }
+    /** The current node as a raw TSNode. */
+    TSNode current() const;
+    /** The current node. */
+    Node node() const;
+    /** The field of the current node (0 if none). */
+    TSFieldId fieldId() const;
+    /** Depth of the current node, relative to the starting node. */
+    uint32_t depth() const;
+
+    /**
+     * @brief Do not visit the descendants of the current node.
+     *
+     * Has no effect on post-order walks, where the descendants have
+     * already been visited.
+     */
+    void skipSubtree() { m_skip = true; }
+private:
+    struct Entry {
+        TSNode node;
+        uint32_t depth;
+        TSFieldId field;
+    };
+
+    void start();
+    bool step();
+    void descendLeftmost();
+
+    const Tree* m_tree = nullptr;
+    TSNode m_root;
+    Order m_order = PreOrder;
+    bool m_namedOnly = false;
+    TSTreeCursor m_cursor;
+    bool m_hasCursor = false;
+    bool m_started = false;
+    bool m_done = true;
+    bool m_skip = false;
+    uint32_t m_depth = 0;
+    std::deque<Entry> m_queue;
+};
+
+}
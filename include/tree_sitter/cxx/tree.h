@@ -13,7 +13,11 @@
 namespace TreeSitter {
 
 class Language;
+class LineIndex;
 class Node;
+class NodeIndex;
+class ParentIndex;
+class PositionIndex;
 class Cursor;
 
 /**
@@ -35,13 +39,13 @@ public:
     /** The highest level node of this tree. */
     Node rootNode() const;
     /** The programming language used by this tree. */
-    Language language() const;
+    const Language& language() const;
 
     /** Create a copy of this tree. */
     Tree copy();
 
     /** @private Only used internally. */
-    std::string source() const;
+    const std::string& source() const;
     /** @private Only used by Parser. */
     TSTree* tree() const;
 
@@ -50,7 +54,54 @@ public:
     /** Construct a walker to navigate this tree. */
     Cursor walk();
     /** A list of changed areas. */
-    std::vector<Range> getChangedRanges(Tree other);
+    std::vector<Range> getChangedRanges(const Tree& other);
+
+    /**
+     * @brief Pre-order numbering of every node, built on first use.
+     *
+     * Shared by every NodeMap of this tree. Editing the tree drops it,
+     * and the next call builds a new one; NodeMaps made before the edit
+     * keep the old numbering.
+     */
+    std::shared_ptr<const NodeIndex> nodeIndex() const;
+
+    /**
+     * @brief Parent and depth of every node, built on first use.
+     *
+     * See ParentIndex.memoryUsage() for its cost. Editing the tree
+     * drops it, and the next call builds a new one.
+     */
+    std::shared_ptr<const ParentIndex> parentIndex() const;
+
+    /** Line start offsets of the source, built on first use. */
+    std::shared_ptr<const LineIndex> lineIndex() const;
+
+    /**
+     * @brief Position to node lookups, built on first use.
+     *
+     * Meant for answering many lookups on the same tree, such as hover
+     * requests. Editing the tree drops it, and the next call builds a
+     * new one.
+     */
+    std::shared_ptr<const PositionIndex> positionIndex() const;
+
+    /**
+     * @brief Convert the column of a position between units.
+     *
+     * Tree-sitter counts columns in bytes; LSP clients usually count
+     * them in UTF-16 code units. See LineIndex.convertColumn().
+     */
+    Point convertPoint(Point point, ColumnUnit from, ColumnUnit to) const;
+
+    /** Returns `true` if nodes use parentIndex() for parent lookups. */
+    bool parentIndexEnabled() const;
+
+    /**
+     * @brief Make Node.parent(), Node.ancestors() and Node.depth() O(1).
+     *
+     * The index is built by the first lookup that needs it.
+     */
+    void setParentIndexEnabled(bool enabled);
 private:
     struct Private;
     std::unique_ptr<Private> d;
@@ -0,0 +1,111 @@
+/**
+ * @file tree_sitter/cpp/typed.h
+ * @brief Base class of the generated typed node wrappers.
+ */
+#pragma once
+
+#include <optional>
+#include <string_view>
+#include <vector>
+#include "tree_sitter/api.h"
+#include "tree_sitter/cxx/children.h"
+#include "tree_sitter/cxx/node.h"
+#include "tree_sitter/cxx/point.h"
+#include "tree_sitter/cxx/tree.h"
+
+namespace TreeSitter {
+
+/**
+ * @brief A node of any type, with typed accessors.
+ *
+ * The build generates a subclass for every named node type of the
+ * built-in grammars in `tree_sitter/cxx/typed/<language>.h`, with one
+ * accessor per field and the field IDs baked in:
+ *
+ * ```c++
+ * if (auto function = TypedNode(node).as<Cpp::FunctionDefinition>()) {
+ *     auto body = function->body(); // std::optional<Cpp::CompoundStatement>
+ * }
+ * ```
+ *
+ * Wrappers hold the tree and the raw TSNode, and every accessor is
+ * inline. Like Node, they are only valid while the tree is alive.
+ */
+class TypedNode {
+public:
+    /** Wrap a raw node of `tree`. */
+    TypedNode(const Tree* tree, TSNode node) : m_tree(tree), m_node(node) { }
+    /** Wrap a node. */
+    explicit TypedNode(const Node& node) : TypedNode(node.tree(), node.node()) { }
+
+    /** Every non-null node is a TypedNode. */
+    static bool is(TSNode node) { return !ts_node_is_null(node); }
+
+    /** The tree this node belongs to. */
+    const Tree* tree() const { return m_tree; }
+    /** The raw TSNode. */
+    TSNode raw() const { return m_node; }
+    /** Convert to a Node. */
+    Node node() const { return Node(m_tree, m_node); }
+
+    /** Node type ID. */
+    TSSymbol typeId() const { return ts_node_symbol(m_node); }
+    /** Node type. */
+    std::string_view type() const { return ts_node_type(m_node); }
+    /** Starting offset. */
+    Index startIndex() const { return ts_node_start_byte(m_node); }
+    /** Ending offset. */
+    Index endIndex() const { return ts_node_end_byte(m_node); }
+    /** Starting position. */
+    Point startPosition() const { return ts_node_start_point(m_node); }
+    /** Ending position. */
+    Point endPosition() const { return ts_node_end_point(m_node); }
+
+    /** The text in the source code, valid while the tree is alive. */
+    std::string_view text() const {
+        const std::string& source = m_tree->source();
+        const Index start = startIndex();
+        const Index end = endIndex();
+        if (start > end || end > source.size()) {
+            return {};
+        }
+        return std::string_view(source).substr(start, end - start);
+    }
+
+    /** This node as `T`, if it has the right type. */
+    template <typename T>
+    std::optional<T> as() const {
+        if (!T::is(m_node)) {
+            return {};
+        }
+        return T(m_tree, m_node);
+    }
+protected:
+    /** The child for a field, if it exists and has the right type. */
+    template <typename T>
+    std::optional<T> fieldChild(TSFieldId field) const {
+        const TSNode child = ts_node_child_by_field_id(m_node, field);
+        if (ts_node_is_null(child) || !T::is(child)) {
+            return {};
+        }
+        return T(m_tree, child);
+    }
+
+    /** Every child for a field that has the right type. */
+    template <typename T>
+    std::vector<T> fieldChildren(TSFieldId field) const {
+        std::vector<T> result;
+        ChildRange children(m_tree, m_node, false);
+        for (auto it = children.begin(); it != children.end(); ++it) {
+            if (it.fieldId() == field && T::is(it.node())) {
+                result.push_back(T(m_tree, it.node()));
+            }
+        }
+        return result;
+    }
+
+    const Tree* m_tree;
+    TSNode m_node;
+};
+
+}
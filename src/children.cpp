@@ -0,0 +1,98 @@
+#include "tree_sitter/api.h"
+#include "tree_sitter/cxx/children.h"
+#include "tree_sitter/cxx/node.h"
+#include "cursor_pool.h"
+
+using namespace TreeSitter;
+
+ChildRange::ChildRange(const Tree* tree, TSNode parent, bool named)
+    : m_tree(tree), m_parent(parent), m_named(named) { }
+
+ChildRange::ChildRange(ChildRange&& range) noexcept
+    : m_tree(range.m_tree),
+      m_parent(range.m_parent),
+      m_cursor(range.m_cursor),
+      m_named(range.m_named),
+      m_hasCursor(range.m_hasCursor),
+      m_done(range.m_done)
+{
+    range.m_hasCursor = false;
+    range.m_done = true;
+}
+
+ChildRange::~ChildRange() {
+    if (m_hasCursor) {
+        Internal::releaseCursor(m_cursor);
+    }
+}
+
+ChildRange::iterator ChildRange::begin() {
+    if (m_hasCursor) {
+        ts_tree_cursor_reset(&m_cursor, m_parent);
+    } else {
+        m_cursor = Internal::acquireCursor(m_parent);
+        m_hasCursor = true;
+    }
+    advance(true);
+    return iterator(this);
+}
+
+void ChildRange::advance(bool first) {
+    bool moved = first
+        ? ts_tree_cursor_goto_first_child(&m_cursor)
+        : ts_tree_cursor_goto_next_sibling(&m_cursor);
+    if (m_named) {
+        while (moved && !ts_node_is_named(ts_tree_cursor_current_node(&m_cursor))) {
+            moved = ts_tree_cursor_goto_next_sibling(&m_cursor);
+        }
+    }
+    m_done = !moved;
+}
+
+uint32_t ChildRange::size() const {
+    return m_named
+        ? ts_node_named_child_count(m_parent)
+        : ts_node_child_count(m_parent);
+}
+
+bool ChildRange::empty() const {
+    return size() == 0;
+}
+
+std::optional<Node> ChildRange::first() const {
+    if (empty()) {
+        return {};
+    }
+    const TSNode child = m_named
+        ? ts_node_named_child(m_parent, 0)
+        : ts_node_child(m_parent, 0);
+    return Node(m_tree, child);
+}
+
+std::optional<Node> ChildRange::last() const {
+    const uint32_t count = size();
+    if (count == 0) {
+        return {};
+    }
+    const TSNode child = m_named
+        ? ts_node_named_child(m_parent, count - 1)
+        : ts_node_child(m_parent, count - 1);
+    return Node(m_tree, child);
+}
+
+Node ChildRange::iterator::operator*() const {
+    return Node(m_range->m_tree, node());
+}
+
+TSNode ChildRange::iterator::node() const {
+    return ts_tree_cursor_current_node(&m_range->m_cursor);
+}
+
+TSFieldId ChildRange::iterator::fieldId() const {
+    return ts_tree_cursor_current_field_id(&m_range->m_cursor);
+}
+
+ChildRange::iterator& ChildRange::iterator::operator++() {
+    m_range->advance(false);
+    return *this;
+}
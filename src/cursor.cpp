@@ -1,14 +1,55 @@
+#include <vector>
 #include "tree_sitter/api.h"
 #include "tree_sitter/cxx/cursor.h"
 #include "tree_sitter/cxx/lang.h"
 #include "tree_sitter/cxx/node.h"
 #include "tree_sitter/cxx/tree.h"
+#include "cursor_pool.h"
 
 using namespace TreeSitter;
 
+namespace {
+
+/** Released cursors beyond this are deleted. */
+constexpr size_t CURSOR_POOL_CAPACITY = 4;
+
+/** Set once the pool of this thread is gone; cursors released later are deleted. */
+thread_local bool cursorPoolDestroyed = false;
+
+struct CursorPool {
+    std::vector<TSTreeCursor> cursors;
+
+    ~CursorPool() {
+        for (auto& cursor : cursors) {
+            ts_tree_cursor_delete(&cursor);
+        }
+        cursorPoolDestroyed = true;
+    }
+};
+
+thread_local CursorPool cursorPool;
+
+}
+
+TSTreeCursor Internal::acquireCursor(TSNode node) {
+    if (cursorPoolDestroyed || cursorPool.cursors.empty()) {
+        return ts_tree_cursor_new(node);
+    }
+    TSTreeCursor cursor = cursorPool.cursors.back();
+    cursorPool.cursors.pop_back();
+    ts_tree_cursor_reset(&cursor, node);
+    return cursor;
+}
+
+void Internal::releaseCursor(TSTreeCursor& cursor) {
+    if (cursorPoolDestroyed || cursorPool.cursors.size() >= CURSOR_POOL_CAPACITY) {
+        ts_tree_cursor_delete(&cursor);
+        return;
+    }
+    cursorPool.cursors.push_back(cursor);
+}
+
 struct Cursor::Private {
-    uint32_t nodeTypeId;
-    std::string nodeType;
     const Tree* tree = nullptr;
     TSTreeCursor cursor;
 };
@@ -37,11 +78,12 @@ void Cursor::reset(Node node) {
 }
 
 std::string Cursor::nodeType() const {
-    const auto types = d->tree->language().nodeTypes();
-    if (types.size() <= d->nodeTypeId) {
+    const auto& types = d->tree->language().nodeTypes();
+    const uint32_t typeId = nodeTypeId();
+    if (types.size() <= typeId) {
         return "";
     }
-    return types[d->nodeTypeId];
+    return types[typeId];
 }
 
 uint32_t Cursor::nodeTypeId() const {
@@ -101,11 +143,7 @@ uint32_t Cursor::currentFieldId() {
 }
 
 std::string Cursor::currentFieldName() {
-    const auto fields = d->tree->language().fields();
-    if (fields.size() <= d->nodeTypeId) {
-        return "";
-    }
-    return fields[currentFieldId()];
+    return std::string(d->tree->language().fieldName(FieldId(currentFieldId())));
 }
 
 bool Cursor::gotoParent() {
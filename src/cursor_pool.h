@@ -0,0 +1,22 @@
+/**
+ * @file cursor_pool.h
+ * @brief Small per-thread pool of tree cursors.
+ *
+ * Creating a TSTreeCursor allocates its stack. Internal walkers borrow
+ * cursors from here instead, so repeated traversals reuse the same stacks.
+ */
+#pragma once
+
+#include "tree_sitter/api.h"
+
+namespace TreeSitter {
+namespace Internal {
+
+/** Borrow a cursor positioned on `node`. */
+TSTreeCursor acquireCursor(TSNode node);
+
+/** Return a cursor obtained from acquireCursor(); deletes it if the pool is full. */
+void releaseCursor(TSTreeCursor& cursor);
+
+}
+}
@@ -0,0 +1,355 @@
+#include <cctype>
+#include <optional>
+#include <string_view>
+#include "tree_sitter/cxx/lang.h"
+
+using namespace TreeSitter;
+
+/** Only this many bytes of content are examined. */
+static constexpr size_t SNIFF_LIMIT = 4 * 1024;
+/** Modelines are looked for in this many leading lines. */
+static constexpr int MODELINE_LINES = 5;
+
+namespace {
+
+struct NameEntry {
+    std::string_view name;
+    Language::Syntax syntax;
+};
+
+/** Lowercase file extensions. `.h` is handled separately. */
+constexpr NameEntry EXTENSIONS[] = {
+    { "c", Language::C },
+    { "cc", Language::Cpp },
+    { "cpp", Language::Cpp },
+    { "cxx", Language::Cpp },
+    { "c++", Language::Cpp },
+    { "hh", Language::Cpp },
+    { "hpp", Language::Cpp },
+    { "hxx", Language::Cpp },
+    { "h++", Language::Cpp },
+    { "ipp", Language::Cpp },
+    { "inl", Language::Cpp },
+    { "tpp", Language::Cpp },
+    { "cs", Language::CSharp },
+    { "csx", Language::CSharp },
+    { "go", Language::Go },
+    { "java", Language::Java },
+    { "js", Language::JavaScript },
+    { "mjs", Language::JavaScript },
+    { "cjs", Language::JavaScript },
+    { "jsx", Language::JavaScript },
+    { "py", Language::Python },
+    { "pyi", Language::Python },
+    { "pyw", Language::Python },
+    { "rs", Language::Rust },
+    { "ts", Language::TypeScript },
+    { "mts", Language::TypeScript },
+    { "cts", Language::TypeScript },
+    { "tsx", Language::TSX },
+};
+
+/** Lowercase Emacs and Vim mode names. */
+constexpr NameEntry MODES[] = {
+    { "c", Language::C },
+    { "c++", Language::Cpp },
+    { "cpp", Language::Cpp },
+    { "cs", Language::CSharp },
+    { "csharp", Language::CSharp },
+    { "go", Language::Go },
+    { "java", Language::Java },
+    { "js", Language::JavaScript },
+    { "js2", Language::JavaScript },
+    { "javascript", Language::JavaScript },
+    { "javascriptreact", Language::JavaScript },
+    { "python", Language::Python },
+    { "rust", Language::Rust },
+    { "rustic", Language::Rust },
+    { "ts", Language::TypeScript },
+    { "typescript", Language::TypeScript },
+    { "tsx", Language::TSX },
+    { "typescriptreact", Language::TSX },
+};
+
+/** Interpreters named on a `#!` line. */
+constexpr NameEntry INTERPRETERS[] = {
+    { "python", Language::Python },
+    { "pypy", Language::Python },
+    { "node", Language::JavaScript },
+    { "nodejs", Language::JavaScript },
+    { "bun", Language::JavaScript },
+    { "ts-node", Language::TypeScript },
+    { "tsx", Language::TypeScript },
+    { "rust-script", Language::Rust },
+    { "dotnet-script", Language::CSharp },
+    { "java", Language::Java },
+    { "tcc", Language::C },
+};
+
+/** Words that only show up in C++ headers. */
+constexpr std::string_view CPP_WORDS[] = {
+    "class", "namespace", "template", "typename", "virtual",
+    "public:", "private:", "protected:", "constexpr", "nullptr",
+};
+
+template <size_t N>
+std::optional<Language::Syntax> lookup(const NameEntry (&table)[N], std::string_view name) {
+    for (const NameEntry& entry : table) {
+        if (entry.name == name) {
+            return entry.syntax;
+        }
+    }
+    return {};
+}
+
+bool isWordChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+/** Lowercase `str` into `buffer`, or return an empty view if it does not fit. */
+template <size_t N>
+std::string_view toLower(std::string_view str, char (&buffer)[N]) {
+    if (str.size() > N) {
+        return {};
+    }
+    for (size_t i=0; i<str.size(); i++) {
+        buffer[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(str[i])));
+    }
+    return std::string_view(buffer, str.size());
+}
+
+/** Returns `true` if `word` occurs in `text` as a whole word. */
+bool containsWord(std::string_view text, std::string_view word) {
+    for (size_t pos = text.find(word); pos != std::string_view::npos; pos = text.find(word, pos + 1)) {
+        const size_t end = pos + word.size();
+        const bool startOk = pos == 0 || !isWordChar(text[pos - 1]);
+        const bool endOk = end >= text.size() || !isWordChar(word.back()) || !isWordChar(text[end]);
+        if (startOk && endOk) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string_view firstLine(std::string_view text) {
+    return text.substr(0, text.find('\n'));
+}
+
+std::string_view trim(std::string_view str) {
+    while (!str.empty() && std::isspace(static_cast<unsigned char>(str.front()))) {
+        str.remove_prefix(1);
+    }
+    while (!str.empty() && (std::isspace(static_cast<unsigned char>(str.back())) || str.back() == ';')) {
+        str.remove_suffix(1);
+    }
+    return str;
+}
+
+std::optional<Language::Syntax> lookupMode(std::string_view mode) {
+    char buffer[32];
+    mode = toLower(trim(mode), buffer);
+    constexpr std::string_view suffix = "-mode";
+    if (mode.size() > suffix.size() && mode.substr(mode.size() - suffix.size()) == suffix) {
+        mode.remove_suffix(suffix.size());
+    }
+    return lookup(MODES, mode);
+}
+
+/** `-*- mode: c++ -*-` or `-*- c++ -*-`. */
+std::optional<Language::Syntax> emacsModeline(std::string_view line) {
+    const size_t start = line.find("-*-");
+    if (start == std::string_view::npos) {
+        return {};
+    }
+    const size_t end = line.find("-*-", start + 3);
+    if (end == std::string_view::npos) {
+        return {};
+    }
+    std::string_view vars = line.substr(start + 3, end - start - 3);
+    const size_t mode = vars.find("mode:");
+    if (mode == std::string_view::npos) {
+        return vars.find(':') == std::string_view::npos ? lookupMode(vars) : std::nullopt;
+    }
+    vars.remove_prefix(mode + 5);
+    return lookupMode(vars.substr(0, vars.find(';')));
+}
+
+/** `vim: set ft=cpp:` and similar. */
+std::optional<Language::Syntax> vimModeline(std::string_view line) {
+    size_t start = std::string_view::npos;
+    for (const std::string_view marker : { "vim:", "vi:", "ex:" }) {
+        const size_t pos = line.find(marker);
+        if (pos != std::string_view::npos && (pos == 0 || std::isspace(static_cast<unsigned char>(line[pos - 1])))) {
+            start = pos + marker.size();
+            break;
+        }
+    }
+    if (start == std::string_view::npos) {
+        return {};
+    }
+    const std::string_view options = line.substr(start);
+    for (const std::string_view key : { "filetype=", "ft=", "syntax=", "syn=" }) {
+        size_t pos = options.find(key);
+        while (pos != std::string_view::npos && pos > 0 && isWordChar(options[pos - 1])) {
+            pos = options.find(key, pos + 1);
+        }
+        if (pos == std::string_view::npos) {
+            continue;
+        }
+        size_t end = pos + key.size();
+        while (end < options.size() && (isWordChar(options[end]) || options[end] == '+')) {
+            end++;
+        }
+        return lookupMode(options.substr(pos + key.size(), end - pos - key.size()));
+    }
+    return {};
+}
+
+std::optional<Language::Syntax> modeline(std::string_view content) {
+    for (int i=0; i<MODELINE_LINES && !content.empty(); i++) {
+        const std::string_view line = firstLine(content);
+        if (auto syntax = emacsModeline(line)) {
+            return syntax;
+        }
+        if (auto syntax = vimModeline(line)) {
+            return syntax;
+        }
+        if (line.size() == content.size()) {
+            break;
+        }
+        content.remove_prefix(line.size() + 1);
+    }
+    return {};
+}
+
+/** `#!/usr/bin/python3` or `#!/usr/bin/env -S node --flag`. */
+std::optional<Language::Syntax> shebang(std::string_view content) {
+    if (content.substr(0, 2) != "#!") {
+        return {};
+    }
+    std::string_view line = firstLine(content.substr(2));
+    std::string_view program;
+    bool viaEnv = false;
+    while (!line.empty()) {
+        line = trim(line);
+        const size_t end = line.find_first_of(" \t");
+        std::string_view word = line.substr(0, end);
+        line = end == std::string_view::npos ? std::string_view() : line.substr(end);
+
+        word = word.substr(word.find_last_of('/') + 1);
+        if (program.empty() && word == "env") {
+            viaEnv = true;
+            continue;
+        }
+        if (viaEnv && (word.substr(0, 1) == "-" || word.find('=') != std::string_view::npos)) {
+            continue;
+        }
+        program = word;
+        break;
+    }
+
+    // python3.11 -> python, pypy3 -> pypy
+    while (!program.empty() && (std::isdigit(static_cast<unsigned char>(program.back())) || program.back() == '.')) {
+        program.remove_suffix(1);
+    }
+    return lookup(INTERPRETERS, program);
+}
+
+/** C and C++ share `.h`; look for C++-only syntax. */
+Language::Syntax headerSyntax(std::string_view content) {
+    for (const std::string_view word : CPP_WORDS) {
+        if (containsWord(content, word)) {
+            return Language::Cpp;
+        }
+    }
+    if (content.find("std::") != std::string_view::npos) {
+        return Language::Cpp;
+    }
+    return Language::C;
+}
+
+/** Closing tags (`</div>`, `</>`) only appear in TSX. */
+bool containsJsx(std::string_view content) {
+    for (size_t pos = content.find("</"); pos != std::string_view::npos; pos = content.find("</", pos + 2)) {
+        const size_t next = pos + 2;
+        if (next < content.size() && (std::isalpha(static_cast<unsigned char>(content[next])) || content[next] == '>')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool startsLine(std::string_view content, std::string_view prefix) {
+    for (size_t pos = content.find(prefix); pos != std::string_view::npos; pos = content.find(prefix, pos + 1)) {
+        if (pos == 0 || content[pos - 1] == '\n') {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** A few unambiguous markers, for files without extension or shebang. */
+std::optional<Language::Syntax> sniff(std::string_view content) {
+    if (startsLine(content, "#include")) {
+        return headerSyntax(content);
+    }
+    if (startsLine(content, "package ") && content.find("\nfunc ") != std::string_view::npos) {
+        return Language::Go;
+    }
+    if (startsLine(content, "use std::") || startsLine(content, "fn main(")) {
+        return Language::Rust;
+    }
+    if (startsLine(content, "using System")) {
+        return Language::CSharp;
+    }
+    if (startsLine(content, "import java.")) {
+        return Language::Java;
+    }
+    if (content.find("if __name__ == \"__main__\":") != std::string_view::npos
+        || content.find("if __name__ == '__main__':") != std::string_view::npos) {
+        return Language::Python;
+    }
+    return {};
+}
+
+std::optional<Language::Syntax> fromExtension(std::string_view path, std::string_view content) {
+    const std::string_view name = path.substr(path.find_last_of("/\\") + 1);
+    const size_t dot = name.find_last_of('.');
+    if (dot == std::string_view::npos || dot == 0) {
+        return {};
+    }
+    const std::string_view extension = name.substr(dot + 1);
+    // Upper case `.C` and `.H` are C++ by convention.
+    if (extension == "C" || extension == "H") {
+        return Language::Cpp;
+    }
+    char buffer[8];
+    const std::string_view lower = toLower(extension, buffer);
+    if (lower == "h") {
+        return headerSyntax(content);
+    }
+    return lookup(EXTENSIONS, lower);
+}
+
+}
+
+std::optional<Language::Syntax> Language::detect(std::string_view path, std::string_view content) {
+    content = content.substr(0, SNIFF_LIMIT);
+
+    // Scripts and modelines cannot tell TypeScript from TSX, so look
+    // for JSX in those. A `.ts` extension is explicit.
+    const auto refine = [content](Syntax syntax) {
+        return syntax == TypeScript && containsJsx(content) ? TSX : syntax;
+    };
+
+    if (const auto syntax = modeline(content)) {
+        return refine(*syntax);
+    }
+    if (const auto syntax = fromExtension(path, content)) {
+        return syntax;
+    }
+    if (const auto syntax = shebang(content)) {
+        return refine(*syntax);
+    }
+    return sniff(content);
+}
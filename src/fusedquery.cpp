@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <stdexcept>
+#include "tree_sitter/cxx/fusedquery.h"
+#include "tree_sitter/cxx/lang.h"
+
+using namespace TreeSitter;
+
+static constexpr uint32_t NO_CAPTURE = UINT32_MAX;
+
+/** Compile the patterns of every query into one query. */
+static Query fuse(const std::vector<Query>& queries) {
+    if (queries.empty()) {
+        throw std::invalid_argument("No queries to fuse");
+    }
+    Language lang = queries[0].language();
+    std::string source;
+    for (const Query& query : queries) {
+        if (query.language().language() != lang.language()) {
+            throw std::invalid_argument("Fused queries must share a language");
+        }
+        source += query.source();
+        source += '\n';
+    }
+    return lang.query(source);
+}
+
+struct FusedQuery::Private {
+    std::vector<Query> queries;
+    Query fused;
+    /** First pattern of every query in the fused query, then the pattern count. */
+    std::vector<uint32_t> patternStarts = {};
+    /** Per query: original capture index of every fused capture. */
+    std::vector<std::vector<uint32_t>> captureMaps = {};
+
+    size_t queryForPattern(uint32_t pattern) const {
+        return std::upper_bound(patternStarts.begin(), patternStarts.end(), pattern) - patternStarts.begin() - 1;
+    }
+
+    /** Rewrite a fused match with the indices of query `index`. */
+    void remap(size_t index, const Query::Match& match, Query::Match& result) const {
+        const std::vector<uint32_t>& captures = captureMaps[index];
+        result.pattern = match.pattern - patternStarts[index];
+        result.captures.clear();
+        for (const Query::Capture& capture : match.captures) {
+            result.captures.push_back({ captures[capture.index], capture.name, capture.node });
+        }
+    }
+};
+
+FusedQuery::FusedQuery(const std::vector<Query>& queries)
+    : d(std::make_unique<Private>(Private { queries, fuse(queries) }))
+{
+    uint32_t start = 0;
+    for (const Query& query : queries) {
+        d->patternStarts.push_back(start);
+        start += query.patternCount();
+    }
+    d->patternStarts.push_back(start);
+    if (start != d->fused.patternCount()) {
+        throw std::logic_error("Fused query has an unexpected number of patterns");
+    }
+
+    const uint32_t captureCount = d->fused.captureCount();
+    for (const Query& query : queries) {
+        std::vector<uint32_t> map(captureCount, NO_CAPTURE);
+        for (uint32_t i=0; i<captureCount; i++) {
+            if (const auto index = query.captureIndex(d->fused.captureName(i))) {
+                map[i] = *index;
+            }
+        }
+        d->captureMaps.push_back(std::move(map));
+    }
+}
+
+FusedQuery::FusedQuery(const FusedQuery& query)
+    : d(std::make_unique<Private>(*query.d)) { }
+
+FusedQuery& FusedQuery::operator=(const FusedQuery &query) {
+    *d = *query.d;
+    return *this;
+}
+
+FusedQuery::~FusedQuery() = default;
+
+size_t FusedQuery::queryCount() const {
+    return d->queries.size();
+}
+
+const Query& FusedQuery::query(size_t index) const {
+    return d->queries.at(index);
+}
+
+const Query& FusedQuery::fused() const {
+    return d->fused;
+}
+
+void FusedQuery::visit(QueryCursor& cursor, const Node& node, const Visitor& visitor) const {
+    Query::Match match;
+    for (const Query::Match& fusedMatch : cursor.eachMatch(d->fused, node)) {
+        const size_t index = d->queryForPattern(fusedMatch.pattern);
+        d->remap(index, fusedMatch, match);
+        visitor(index, match);
+    }
+}
+
+std::vector<std::vector<Query::Match>> FusedQuery::matches(const Node& node) const {
+    std::vector<std::vector<Query::Match>> result(d->queries.size());
+    QueryCursor cursor;
+    visit(cursor, node, [&result](size_t index, const Query::Match& match) {
+        result[index].push_back(match);
+    });
+    return result;
+}
+
+std::vector<std::vector<Query::Capture>> FusedQuery::captures(const Node& node) const {
+    std::vector<std::vector<Query::Capture>> result(d->queries.size());
+    QueryCursor cursor;
+    for (const Query::Capture& capture : cursor.eachCapture(d->fused, node)) {
+        const size_t index = d->queryForPattern(cursor.currentMatch().pattern);
+        result[index].push_back({ d->captureMaps[index][capture.index], capture.name, capture.node });
+    }
+    return result;
+}
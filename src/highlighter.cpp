@@ -0,0 +1,372 @@
+#include <algorithm>
+#include <cstdlib>
+#include <unordered_map>
+#include "tree_sitter/cxx/highlighter.h"
+#include "tree_sitter/cxx/node.h"
+#include "tree_sitter/cxx/parser.h"
+#include "tree_sitter/cxx/tree.h"
+
+using namespace TreeSitter;
+
+namespace {
+
+constexpr uint32_t NO_HIGHLIGHT = UINT32_MAX;
+constexpr int DEFAULT_PRIORITY = 100;
+/** Injections nested deeper than this are not highlighted. */
+constexpr uint32_t MAX_INJECTION_DEPTH = 4;
+
+/** A capture that may become a span. */
+struct Candidate {
+    Index startIndex;
+    Index endIndex;
+    /** 0 for the tree, 1 for the text injected in it, and so on. */
+    uint32_t depth;
+    int priority;
+    uint32_t pattern;
+    uint32_t highlight;
+};
+
+/** Index of the longest name that is `capture` or a dotted prefix of it. */
+uint32_t resolveHighlight(const std::vector<std::string>& names, std::string_view capture) {
+    uint32_t result = NO_HIGHLIGHT;
+    size_t length = 0;
+    for (uint32_t i=0; i<names.size(); i++) {
+        const std::string& name = names[i];
+        if (name.size() <= length || capture.compare(0, name.size(), name) != 0) {
+            continue;
+        }
+        if (capture.size() == name.size() || capture[name.size()] == '.') {
+            result = i;
+            length = name.size();
+        }
+    }
+    return result;
+}
+
+/** Append a span, merging it with the previous one if they touch and match. */
+void emit(std::vector<Highlighter::Span>& spans, Index start, Index end, uint32_t highlight) {
+    if (start >= end) {
+        return;
+    }
+    if (!spans.empty() && spans.back().endIndex == start && spans.back().highlight == highlight) {
+        spans.back().endIndex = end;
+        return;
+    }
+    spans.push_back({ start, end, highlight });
+}
+
+/** Resolve candidates into non-overlapping spans; innermost wins. */
+std::vector<Highlighter::Span> resolve(std::vector<Candidate>& candidates, Index startIndex, Index endIndex) {
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        if (a.startIndex != b.startIndex) return a.startIndex < b.startIndex;
+        if (a.endIndex != b.endIndex) return a.endIndex > b.endIndex;
+        if (a.depth != b.depth) return a.depth < b.depth;
+        if (a.priority != b.priority) return a.priority > b.priority;
+        return a.pattern < b.pattern;
+    });
+
+    std::vector<Highlighter::Span> spans;
+    const auto clippedEmit = [&spans, startIndex, endIndex](Index start, Index end, uint32_t highlight) {
+        emit(spans, std::max(start, startIndex), std::min(end, endIndex), highlight);
+    };
+
+    // Open candidates; each one lies within the one below it.
+    struct Open {
+        Index endIndex;
+        uint32_t highlight;
+    };
+    std::vector<Open> stack;
+    Index position = 0;
+    const Candidate* previous = nullptr;
+    for (const Candidate& candidate : candidates) {
+        // The same node, captured again with a lower rank.
+        if (previous && previous->startIndex == candidate.startIndex
+            && previous->endIndex == candidate.endIndex && previous->depth == candidate.depth) {
+            continue;
+        }
+        previous = &candidate;
+
+        while (!stack.empty() && stack.back().endIndex <= candidate.startIndex) {
+            clippedEmit(position, stack.back().endIndex, stack.back().highlight);
+            position = stack.back().endIndex;
+            stack.pop_back();
+        }
+        Index end = candidate.endIndex;
+        if (!stack.empty()) {
+            clippedEmit(position, candidate.startIndex, stack.back().highlight);
+            // Partial overlaps only happen across injections; keep the nesting.
+            end = std::min(end, stack.back().endIndex);
+        }
+        position = candidate.startIndex;
+        stack.push_back({ end, candidate.highlight });
+    }
+    while (!stack.empty()) {
+        clippedEmit(position, stack.back().endIndex, stack.back().highlight);
+        position = stack.back().endIndex;
+        stack.pop_back();
+    }
+    return spans;
+}
+
+/** The text of `node` to parse as an injection. */
+std::vector<Range> injectionRanges(const Node& node, bool includeChildren) {
+    const TSNode content = node.node();
+    std::vector<Range> ranges;
+    Range range = { ts_node_start_point(content), {}, ts_node_start_byte(content), 0 };
+    if (!includeChildren) {
+        const uint32_t count = ts_node_child_count(content);
+        for (uint32_t i=0; i<count; i++) {
+            const TSNode child = ts_node_child(content, i);
+            range.end_point = ts_node_start_point(child);
+            range.end_byte = ts_node_start_byte(child);
+            if (range.start_byte < range.end_byte) {
+                ranges.push_back(range);
+            }
+            range.start_point = ts_node_end_point(child);
+            range.start_byte = ts_node_end_byte(child);
+        }
+    }
+    range.end_point = ts_node_end_point(content);
+    range.end_byte = ts_node_end_byte(content);
+    if (range.start_byte < range.end_byte) {
+        ranges.push_back(range);
+    }
+    return ranges;
+}
+
+}
+
+bool Highlighter::Span::operator==(const Span& span) const {
+    return startIndex == span.startIndex && endIndex == span.endIndex && highlight == span.highlight;
+}
+
+bool Highlighter::Span::operator!=(const Span& span) const {
+    return !(*this == span);
+}
+
+struct Highlighter::Private {
+    /** A Config, with its captures resolved. */
+    struct Layer {
+        Config config;
+        /** Highlight of every capture of the highlights query. */
+        std::vector<uint32_t> highlights = {};
+        /** Priority of every pattern of the highlights query. */
+        std::vector<int> priorities = {};
+        std::optional<uint32_t> contentCapture = std::nullopt;
+        std::optional<uint32_t> languageCapture = std::nullopt;
+    };
+
+    /** A parser for each injected layer, kept for one highlight() or update() call. */
+    using Parsers = std::unordered_map<const Layer*, Parser>;
+
+    std::vector<std::string> names;
+    Layer root;
+    std::unordered_map<std::string, Layer> injections = {};
+
+    Layer makeLayer(const Config& config) const;
+    void collect(const Layer& layer, const Tree& tree, Index startIndex, Index endIndex,
+        uint32_t depth, Parsers& parsers, std::vector<Candidate>& candidates) const;
+    std::vector<Span> highlight(const Tree& tree, Index startIndex, Index endIndex, Parsers& parsers) const;
+};
+
+Highlighter::Private::Layer Highlighter::Private::makeLayer(const Config& config) const {
+    Layer layer = { config };
+    const Query& query = config.highlights;
+    for (uint32_t i=0; i<query.captureCount(); i++) {
+        layer.highlights.push_back(resolveHighlight(names, query.captureName(i)));
+    }
+    for (uint32_t i=0; i<query.patternCount(); i++) {
+        const Query::Properties& properties = query.setProperties(i);
+        const auto priority = properties.find("priority");
+        layer.priorities.push_back(priority == properties.end()
+            ? DEFAULT_PRIORITY
+            : std::atoi(priority->second.c_str()));
+    }
+    if (config.injections) {
+        layer.contentCapture = config.injections->captureIndex("injection.content");
+        layer.languageCapture = config.injections->captureIndex("injection.language");
+    }
+    return layer;
+}
+
+void Highlighter::Private::collect(const Layer& layer, const Tree& tree, Index startIndex, Index endIndex,
+    uint32_t depth, Parsers& parsers, std::vector<Candidate>& candidates) const
+{
+    QueryCursor cursor;
+    cursor.setByteRange(startIndex, endIndex);
+    for (const Query::Capture& capture : cursor.eachCapture(layer.config.highlights, tree.rootNode())) {
+        const uint32_t highlight = layer.highlights[capture.index];
+        if (highlight == NO_HIGHLIGHT) {
+            continue;
+        }
+        const uint32_t pattern = cursor.currentMatch().pattern;
+        candidates.push_back({
+            capture.node.startIndex(),
+            capture.node.endIndex(),
+            depth,
+            layer.priorities[pattern],
+            pattern,
+            highlight,
+        });
+    }
+
+    if (!layer.config.injections || !layer.contentCapture || depth >= MAX_INJECTION_DEPTH) {
+        return;
+    }
+    const Query& query = *layer.config.injections;
+    for (const Query::Match& match : cursor.eachMatch(query, tree.rootNode())) {
+        const Query::Properties& properties = query.setProperties(match.pattern);
+        std::string language;
+        if (const auto name = properties.find("injection.language"); name != properties.end()) {
+            language = name->second;
+        }
+        std::vector<Range> ranges;
+        const bool includeChildren = properties.count("injection.include-children") > 0;
+        for (const Query::Capture& capture : match.captures) {
+            if (capture.index == layer.contentCapture) {
+                const auto content = injectionRanges(capture.node, includeChildren);
+                ranges.insert(ranges.end(), content.begin(), content.end());
+            } else if (capture.index == layer.languageCapture) {
+                language = capture.node.text();
+            }
+        }
+
+        const auto injected = injections.find(language);
+        if (ranges.empty() || injected == injections.end()) {
+            continue;
+        }
+        const auto [parser, added] = parsers.try_emplace(&injected->second);
+        if (added) {
+            parser->second.setLanguage(injected->second.config.highlights.language());
+        }
+        parser->second.setIncludedRanges(ranges);
+        const Tree injectedTree = parser->second.parse(tree.source());
+        collect(injected->second, injectedTree, startIndex, endIndex, depth + 1, parsers, candidates);
+    }
+}
+
+std::vector<Highlighter::Span> Highlighter::Private::highlight(const Tree& tree, Index startIndex, Index endIndex,
+    Parsers& parsers) const
+{
+    std::vector<Candidate> candidates;
+    collect(root, tree, startIndex, endIndex, 0, parsers, candidates);
+    return resolve(candidates, startIndex, endIndex);
+}
+
+Highlighter::Highlighter(const std::vector<std::string>& names, const Config& config)
+    : d(std::make_unique<Private>(Private { names, { config } }))
+{
+    d->root = d->makeLayer(config);
+}
+
+Highlighter::Highlighter(const Highlighter& highlighter)
+    : d(std::make_unique<Private>(*highlighter.d)) { }
+
+Highlighter& Highlighter::operator=(const Highlighter &highlighter) {
+    *d = *highlighter.d;
+    return *this;
+}
+
+Highlighter::~Highlighter() = default;
+
+const std::vector<std::string>& Highlighter::names() const {
+    return d->names;
+}
+
+void Highlighter::addInjection(const std::string& name, const Config& config) {
+    d->injections.insert_or_assign(name, d->makeLayer(config));
+}
+
+std::vector<Highlighter::Span> Highlighter::highlight(const Tree& tree) const {
+    return highlight(tree, 0, UINT32_MAX);
+}
+
+std::vector<Highlighter::Span> Highlighter::highlight(const Tree& tree, Index startIndex, Index endIndex) const {
+    Private::Parsers parsers;
+    return d->highlight(tree, startIndex, endIndex, parsers);
+}
+
+std::vector<Highlighter::Update> Highlighter::update(const Tree& oldTree, const Tree& newTree, const Edit& edit) const {
+    std::vector<std::pair<Index, Index>> areas;
+    uint32_t count;
+    TSRange* ranges = ts_tree_get_changed_ranges(oldTree.tree(), newTree.tree(), &count);
+    for (uint32_t i=0; i<count; i++) {
+        areas.emplace_back(ranges[i].start_byte, ranges[i].end_byte);
+    }
+    free(ranges);
+    // Text edits that keep the structure are not reported as changes.
+    areas.emplace_back(edit.startIndex, edit.newEndIndex);
+
+    // Extend to whole lines, then merge.
+    const std::string& source = newTree.source();
+    for (auto& [start, end] : areas) {
+        start = std::min<Index>(start, source.size());
+        const size_t lineStart = start == 0 ? std::string::npos : source.rfind('\n', start - 1);
+        start = lineStart == std::string::npos ? 0 : lineStart + 1;
+        const size_t lineEnd = source.find('\n', std::max(start, end));
+        end = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+    }
+    std::sort(areas.begin(), areas.end());
+
+    std::vector<Update> updates;
+    for (const auto& [start, end] : areas) {
+        if (!updates.empty() && start <= updates.back().endIndex) {
+            updates.back().endIndex = std::max(updates.back().endIndex, end);
+        } else {
+            updates.push_back({ start, end, {} });
+        }
+    }
+    Private::Parsers parsers;
+    for (Update& update : updates) {
+        update.spans = d->highlight(newTree, update.startIndex, update.endIndex, parsers);
+    }
+    return updates;
+}
+
+void Highlighter::apply(std::vector<Span>& spans, const Edit& edit, const std::vector<Update>& updates) {
+    // Move the old spans to the new source; the edited text is in an update.
+    std::vector<Span> moved;
+    moved.reserve(spans.size());
+    for (const Span& span : spans) {
+        if (span.startIndex < edit.startIndex) {
+            moved.push_back({ span.startIndex, std::min(span.endIndex, edit.startIndex), span.highlight });
+        }
+        if (span.endIndex > edit.oldEndIndex) {
+            const Index start = std::max(span.startIndex, edit.oldEndIndex);
+            moved.push_back({
+                start - edit.oldEndIndex + edit.newEndIndex,
+                span.endIndex - edit.oldEndIndex + edit.newEndIndex,
+                span.highlight,
+            });
+        }
+    }
+
+    // Cut the updated areas out, and put their new spans in.
+    std::vector<Span> pieces;
+    for (const Span& span : moved) {
+        Index start = span.startIndex;
+        auto update = std::partition_point(updates.begin(), updates.end(), [start](const Update& update) {
+            return update.endIndex <= start;
+        });
+        for (; update != updates.end() && update->startIndex < span.endIndex; ++update) {
+            if (start < update->startIndex) {
+                pieces.push_back({ start, update->startIndex, span.highlight });
+            }
+            start = std::max(start, update->endIndex);
+        }
+        if (start < span.endIndex) {
+            pieces.push_back({ start, span.endIndex, span.highlight });
+        }
+    }
+    for (const Update& update : updates) {
+        pieces.insert(pieces.end(), update.spans.begin(), update.spans.end());
+    }
+    std::sort(pieces.begin(), pieces.end(), [](const Span& a, const Span& b) {
+        return a.startIndex < b.startIndex;
+    });
+
+    spans.clear();
+    for (const Span& piece : pieces) {
+        emit(spans, piece.startIndex, piece.endIndex, piece.highlight);
+    }
+}
@@ -1,30 +1,85 @@
+#include <algorithm>
 #include <map>
+#include <mutex>
 #include <regex>
 #include <sstream>
 #include <stdexcept>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include "tree_sitter/api.h"
 #include "tree_sitter/cxx/lang.h"
 #include "tree_sitter/cxx/query.h"
 #include "tree_sitter/langs.h"
+#include "query_p.h"
 
 using namespace TreeSitter;
 
 static const std::regex QUERY_WORD_REGEX("([\\w-.]*)");
 
-struct Step {
-    std::string type;
-    std::string name;
-    std::string value;
-};
+namespace {
 
-struct Language::Private {
-    int version = 0;
+/** Read-only tables describing one grammar. */
+struct Metadata {
+    uint32_t version = 0;
     int fieldCount = 0;
     int nodeTypeCount = 0;
+    /** Name of every symbol, indexed by symbol ID. */
+    std::vector<std::string> nodeTypes = {};
+    /** Name of every field, indexed by field ID. Entry 0 is empty. */
+    std::vector<std::string> fields = {};
+    /** Field names sorted by name, pointing into `fields`. */
+    std::vector<std::pair<std::string_view, TSFieldId>> fieldsByName = {};
+};
+
+std::shared_ptr<const Metadata> buildMetadata(const TSLanguage* lang) {
+    auto meta = std::make_shared<Metadata>();
+    meta->version = ts_language_version(lang);
+    meta->nodeTypeCount = ts_language_symbol_count(lang);
+    meta->fieldCount = ts_language_field_count(lang);
+
+    meta->nodeTypes.reserve(meta->nodeTypeCount);
+    for (int i=0; i<meta->nodeTypeCount; i++) {
+        const char* name = ts_language_symbol_name(lang, static_cast<TSSymbol>(i));
+        meta->nodeTypes.emplace_back(name == nullptr ? "" : name);
+    }
+
+    // Field IDs start at 1.
+    meta->fields.resize(meta->fieldCount + 1);
+    for (int i=1; i<=meta->fieldCount; i++) {
+        const char* name = ts_language_field_name_for_id(lang, static_cast<TSFieldId>(i));
+        if (name != nullptr) {
+            meta->fields[i] = name;
+        }
+    }
+    // Built after `fields` stopped growing so the views stay valid.
+    for (int i=1; i<=meta->fieldCount; i++) {
+        if (!meta->fields[i].empty()) {
+            meta->fieldsByName.emplace_back(meta->fields[i], static_cast<TSFieldId>(i));
+        }
+    }
+    std::sort(meta->fieldsByName.begin(), meta->fieldsByName.end());
+    return meta;
+}
+
+/** Metadata of a grammar, built on first use and shared by every Language. */
+std::shared_ptr<const Metadata> metadataFor(const TSLanguage* lang) {
+    static std::mutex mutex;
+    static std::unordered_map<const TSLanguage*, std::shared_ptr<const Metadata>> registry;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& meta = registry[lang];
+    if (!meta) {
+        meta = buildMetadata(lang);
+    }
+    return meta;
+}
+
+}
+
+struct Language::Private {
     const TSLanguage* lang = nullptr;
-    std::unordered_map<int, std::string> types = {};
-    std::unordered_map<int, std::string> fields = {};
+    std::shared_ptr<const Metadata> meta = nullptr;
 };
 
 Language::Language(Syntax syntax)
@@ -88,53 +143,27 @@ Language& Language::operator=(const Language &lang) {
 Language::~Language() = default;
 
 void Language::init() {
-    const int symbolCount = ts_language_symbol_count(d->lang);
-    const int fieldCount = ts_language_field_count(d->lang);
-
-    for (int i=0; i<symbolCount; i++) {
-        if (ts_language_symbol_type(d->lang, i) < 2) {
-            d->types[i] = ts_language_symbol_name(d->lang, i);
-        }
-    }
-
-    for (int i=0; i<fieldCount; i++) {
-        const char* fieldName = ts_language_field_name_for_id(d->lang, i);
-        if (fieldName != nullptr) {
-            d->fields[i] = fieldName;
-        }
-    }
-
-    d->nodeTypeCount = symbolCount;
-    d->fieldCount = fieldCount;
-    d->version = ts_language_version(d->lang);
+    d->meta = metadataFor(d->lang);
 }
 
 uint32_t Language::version() const {
-    return d->version;
+    return d->meta->version;
 }
 
 int Language::fieldCount() const {
-    return d->fieldCount;
+    return d->meta->fieldCount;
 }
 
-std::vector<std::string> Language::fields() const {
-    std::vector<std::string> fields;
-    for (auto field : d->fields) {
-        fields.push_back(field.second);
-    }
-    return fields;
+const std::vector<std::string>& Language::fields() const {
+    return d->meta->fields;
 }
 
 int Language::nodeTypeCount() const {
-    return d->nodeTypeCount;
+    return d->meta->nodeTypeCount;
 }
 
-std::vector<std::string> Language::nodeTypes() const {
-    std::vector<std::string> nodeTypes;
-    for (auto nodeType : d->types) {
-        nodeTypes.push_back(nodeType.second);
-    }
-    return nodeTypes;
+const std::vector<std::string>& Language::nodeTypes() const {
+    return d->meta->nodeTypes;
 }
 
 const TSLanguage* Language::language() const {
@@ -155,6 +184,23 @@ std::string Language::nodeTypeForId(int typeId) {
     return std::string(ret);
 }
 
+SymbolSet Language::symbolsForTypes(const std::vector<std::string>& types) const {
+    const std::unordered_set<std::string_view> names(types.begin(), types.end());
+    const uint32_t symbolCount = ts_language_symbol_count(d->lang);
+    SymbolSet symbols;
+    for (uint32_t i=0; i<symbolCount; i++) {
+        const TSSymbol symbol = static_cast<TSSymbol>(i);
+        if (ts_language_symbol_type(d->lang, symbol) > TSSymbolTypeAnonymous) {
+            continue;
+        }
+        const char* name = ts_language_symbol_name(d->lang, symbol);
+        if (name != nullptr && names.count(name) > 0) {
+            symbols.insert(symbol);
+        }
+    }
+    return symbols;
+}
+
 bool Language::nodeTypeIsNamed(int typeId) {
     const TSSymbolType symbolType = ts_language_symbol_type(d->lang, typeId);
     return symbolType == TSSymbolTypeRegular;
@@ -166,28 +212,40 @@ bool Language::nodeTypeIsVisible(int typeId) {
 }
 
 bool Language::hasFieldId(int fieldId) {
-    return d->fields.find(fieldId) != d->fields.end();
+    return fieldId > 0 && fieldId <= d->meta->fieldCount && !d->meta->fields[fieldId].empty();
 }
 
 std::string Language::fieldNameForId(int fieldId) {
     if (!hasFieldId(fieldId)) {
         return "";
     }
-    return d->fields.find(fieldId)->second;
+    return d->meta->fields[fieldId];
 }
 
 int Language::fieldIdForName(const std::string& fieldName) {
-    for (auto field : d->fields) {
-        if (field.second == fieldName) {
-            return field.first;
-        }
-    }
-    return -1;
+    const FieldId id = field(fieldName);
+    return id ? id.id() : -1;
 }
 
 bool Language::hasFieldName(const std::string &fieldName) {
-    // TODO: might keep vector<std::string> fieldNames for faster lookup.
-    return fieldIdForName(fieldName) == -1;
+    return field(fieldName).valid();
+}
+
+FieldId Language::field(std::string_view name) const {
+    const auto& fields = d->meta->fieldsByName;
+    const auto it = std::lower_bound(fields.begin(), fields.end(), name,
+        [](const auto& field, std::string_view name) { return field.first < name; });
+    if (it == fields.end() || it->first != name) {
+        return FieldId();
+    }
+    return FieldId(it->second);
+}
+
+std::string_view Language::fieldName(FieldId field) const {
+    if (field.id() >= d->meta->fields.size()) {
+        return {};
+    }
+    return d->meta->fields[field.id()];
 }
 
 Query Language::query(const std::string &source) {
@@ -232,180 +290,45 @@ Query Language::query(const std::string &source) {
       }
     }
 
-    const uint32_t stringCount = ts_query_string_count(address);
-    const uint32_t captureCount = ts_query_capture_count(address);
-    const uint32_t patternCount = ts_query_pattern_count(address);
-    std::vector<std::string> captureNames(captureCount);
-    std::vector<std::string> stringValues(stringCount);
-    for (int i=0; i<captureCount; i++) {
-      uint32_t len;
-      const auto nameAddress = ts_query_capture_name_for_id(
-        address,
-        i,
-        &len
-      );
-      captureNames.push_back(std::string(nameAddress, len));
+    return Query(Internal::compileQuery(address, d->lang, source));
+}
+
+SymbolSet::SymbolSet(std::initializer_list<TSSymbol> symbols) {
+    for (const TSSymbol symbol : symbols) {
+        insert(symbol);
     }
+}
 
-    for (int i=0; i<stringCount; i++) {
-      uint32_t len;
-      const auto valueAddress = ts_query_string_value_for_id(
-        address,
-        i,
-        &len
-      );
-      stringValues.push_back(std::string(valueAddress, len));
+void SymbolSet::insert(TSSymbol symbol) {
+    const size_t word = symbol / 64;
+    if (word >= m_bits.size()) {
+        m_bits.resize(word + 1, 0);
     }
+    m_bits[word] |= uint64_t(1) << (symbol % 64);
+}
 
-    std::vector<Query::Properties> setProperties(patternCount);
-    std::vector<Query::Properties> assertedProperties(patternCount);
-    std::vector<Query::Properties> refutedProperties(patternCount);
-    std::vector<std::vector<Query::PredicateResult>> predicates(patternCount);
-    std::vector<std::vector<Query::TextPredicate>> textPredicates(patternCount);
-
-    for (int i=0; i<patternCount; i++) {
-      uint32_t stepCount;
-      const TSQueryPredicateStep* predicatesAddress = ts_query_predicates_for_pattern(
-        address,
-        i,
-        &stepCount
-      );
-
-      predicates[i] = {};
-      textPredicates[i] = {};
-
-      std::vector<Step> steps;
-      const TSQueryPredicateStep* stepAddress = predicatesAddress;
-
-      for (uint32_t j=0; j<stepCount; j++) {
-        const auto stepType = stepAddress[i].type;
-        const uint32_t stepValueId = stepAddress[i].value_id;
-        if (stepType == TSQueryPredicateStepTypeCapture) {
-          steps.push_back({ "capture", captureNames[stepValueId], "" });
-        } else if (stepType == TSQueryPredicateStepTypeString) {
-          steps.push_back({ "string", "", stringValues[stepValueId] });
-        } else if (steps.size() > 0) {
-          if (steps[0].type != "string") {
-            throw std::runtime_error("Predicates must begin with a literal value");
-          }
-          const std::string operatorName = steps[0].value;
-          bool isPositive = true;
-          if (operatorName == "not-eq?") {
-            isPositive = false;
-          } else if (operatorName == "eq?") {
-            if (steps.size() != 3) {
-              //Expected 2, got ${steps.length - 1}
-              throw std::runtime_error("Wrong number of arguments to `#eq?` predicate");
-            } else if(steps[1].type != "capture") {
-              //Got "${steps[1].value}:
-              throw std::runtime_error("First argument of `#eq?` predicate must be a capture");
-            } else if (steps[2].type == "capture") {
-              const std::string captureName1 = steps[1].name;
-              const std::string captureName2 = steps[2].name;
-              Query::TextPredicate fn = [&captureName1, &captureName2, &isPositive](std::vector<Query::Capture> captures) -> bool {
-                std::optional<Node> node1;
-                std::optional<Node> node2;
-                for (auto c : captures) {
-                  if (c.name == captureName1) node1 = c.node;
-                  if (c.name == captureName2) node2 = c.node;
-                }
-                if (!node1.has_value() || !node2.has_value()) return true;
-                return (node1.value().text() == node2.value().text()) == isPositive;
-              };
-              textPredicates[i].push_back(fn);
-            } else {
-              const std::string captureName = steps[1].name;
-              const std::string stringValue = steps[2].value;
-              Query::TextPredicate fn = [&captureName, &stringValue, &isPositive](std::vector<Query::Capture> captures) -> bool {
-                for (auto c : captures) {
-                  if (c.name == captureName) {
-                    return (c.node.text() == stringValue) == isPositive;
-                  };
-                }
-                return true;
-              };
-              textPredicates[i].push_back(fn);
-            }
-          } else if (operatorName == "not-match?") {
-            isPositive = false;
-          } else if (operatorName == "match?") {
-            if (steps.size() != 3) {
-              // Expected 2, got ${steps.length - 1}
-              throw std::runtime_error("Wrong number of arguments to `#match?` predicate");
-            } else if (steps[1].type != "capture") {
-              // Got "${steps[1].value}"
-              throw std::runtime_error("First argument of `#match?` predicate must be a capture");
-            } else if (steps[2].type != "string") {
-              // Got @${steps[2].value}
-              throw std::runtime_error("Second argument of `#match?` predicate must be a string");
-            }
-            const std::string captureName = steps[1].name;
-            const std::regex regex(steps[2].value);
-            Query::TextPredicate fn = [&captureName, &regex, &isPositive](std::vector<Query::Capture> captures) -> bool {
-              for (auto c : captures) {
-                if (c.name == captureName) {
-                  return std::regex_match(c.name, regex) == isPositive;
-                }
-              }
-              return true;
-            };
-            textPredicates[i].push_back(fn);
-          } else if (operatorName == "set!") {
-            if (steps.size() < 2 || steps.size() > 3) {
-              // Expected 1 or 2. Got ${steps.length - 1}
-              throw std::runtime_error("Wrong number of arguments to `#set!` predicate");
-            }
-            for (auto s : steps) {
-              if (s.type != "string") {
-                throw std::runtime_error("Arguments to `#set!` predicate must be a strings");
-              }
-            }
-            //if (!setProperties[i]) setProperties[i] = {};
-            //setProperties[i][steps[1].value] = steps[2] ? steps[2].value : "";
-            setProperties[i][steps[1].value] = steps.size() == 3 ? steps[2].value : "";
-          } else if (operatorName == "is?" || operatorName == "is-not?") {
-            if (steps.size() < 2 || steps.size() > 3) {
-              const std::string err = operatorName == "is?"
-                ? "Wrong number of arguments to `#is?` predicate"
-                : "Wrong number of arguments to `#is-not?` predicate";
-              throw std::runtime_error(err);
-            }
-            for (auto s : steps) {
-              if (s.type != "string") {
-                const std::string err = operatorName == "is?"
-                  ? "Arguments to `#is?` predicate must be a strings"
-                  : "Arguments to `#is-not?` predicate must be a strings";
-                throw std::runtime_error(err);
-              }
-            }
-            if (operatorName == "is?") {
-              //if (!assertedProperties[i]) assertedProperties[i] = {};
-              assertedProperties[i][steps[1].value] = steps.size() == 3 ? steps[2].value : "";
-            } else {
-              //if (!refutedProperties[i]) refutedProperties[i] = {};
-              refutedProperties[i][steps[1].value] = steps.size() == 3 ? steps[2].value : "";
-            }
-          } else {
-            // predicates[i].push({operator, operands: steps.slice(1)});
-            std::vector<Query::Operand> ops;
-            for (int i=1; i<steps.size(); i++) {
-              Query::Operand op = { steps[i].name, steps[i].type };
-              ops.push_back(op);
-            }
-            predicates[i].push_back({ operatorName, ops });
-          }
-          steps.clear();
+void SymbolSet::erase(TSSymbol symbol) {
+    const size_t word = symbol / 64;
+    if (word < m_bits.size()) {
+        m_bits[word] &= ~(uint64_t(1) << (symbol % 64));
+    }
+}
+
+size_t SymbolSet::size() const {
+    size_t count = 0;
+    for (uint64_t bits : m_bits) {
+        for (; bits != 0; bits &= bits - 1) {
+            count++;
         }
-      }
     }
+    return count;
+}
 
-    return Query(
-      address,
-      captureNames,
-      textPredicates,
-      predicates,
-      setProperties,
-      assertedProperties,
-      refutedProperties
-    );
+bool SymbolSet::empty() const {
+    for (const uint64_t bits : m_bits) {
+        if (bits != 0) {
+            return false;
+        }
+    }
+    return true;
 }
@@ -0,0 +1,310 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "tree_sitter/cxx/lines.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TREE_SITTER_CXX_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace TreeSitter;
+
+namespace {
+
+/** A multi-byte (or invalid) character in a non-ASCII line. */
+struct WideChar {
+    /** Columns where the character starts, per unit. */
+    uint32_t start[3];
+    /** Byte length of the character. */
+    uint8_t bytes;
+    /** UTF-16 length of the character. */
+    uint8_t units;
+
+    uint32_t length(ColumnUnit unit) const {
+        switch (unit) {
+        case ColumnUnit::Bytes: return bytes;
+        case ColumnUnit::UTF16: return units;
+        default: return 1;
+        }
+    }
+};
+
+}
+
+struct LineIndex::Private {
+    std::shared_ptr<const std::string> source = nullptr;
+    /** Offset of the first byte of every line. */
+    std::vector<Index> starts = {};
+    /** Multi-byte characters of every line, grouped by line. */
+    std::vector<WideChar> chars = {};
+    /** End of each line's group in `chars`; empty if every line is ASCII. */
+    std::vector<uint32_t> charEnds = {};
+
+    void indexLine(uint32_t row);
+    void indexWideChars();
+};
+
+static inline unsigned countTrailingZeros(unsigned mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+/** Push the offset following every `\n` in `data`. */
+static void scanNewlines(const char* data, size_t length, std::vector<Index>& starts) {
+    size_t i = 0;
+#ifdef TREE_SITTER_CXX_SSE2
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; i + 16 <= length; i += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+        while (mask != 0) {
+            starts.push_back(static_cast<Index>(i + countTrailingZeros(mask) + 1));
+            mask &= mask - 1;
+        }
+    }
+#endif
+    while (i < length) {
+        const void* found = std::memchr(data + i, '\n', length - i);
+        if (found == nullptr) {
+            break;
+        }
+        i = static_cast<const char*>(found) - data + 1;
+        starts.push_back(static_cast<Index>(i));
+    }
+}
+
+/** Offset of the first byte >= 0x80 at or after `i`, or `length`. */
+static size_t findNonAscii(const char* data, size_t i, size_t length) {
+#ifdef TREE_SITTER_CXX_SSE2
+    for (; i + 16 <= length; i += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const unsigned mask = _mm_movemask_epi8(chunk);
+        if (mask != 0) {
+            return i + countTrailingZeros(mask);
+        }
+    }
+#endif
+    for (; i < length; i++) {
+        if (static_cast<unsigned char>(data[i]) >= 0x80) {
+            return i;
+        }
+    }
+    return length;
+}
+
+/** Length of the UTF-8 sequence at `data`, or 1 if it is invalid. */
+static uint8_t sequenceLength(const unsigned char* data, size_t available) {
+    const unsigned char lead = data[0];
+    uint8_t length = 1;
+    if (lead >= 0xf0 && lead <= 0xf4) {
+        length = 4;
+    } else if (lead >= 0xe0) {
+        length = lead <= 0xef ? 3 : 1;
+    } else if (lead >= 0xc2) {
+        length = 2;
+    }
+    if (length > available) {
+        return 1;
+    }
+    for (uint8_t i=1; i<length; i++) {
+        if ((data[i] & 0xc0) != 0x80) {
+            return 1;
+        }
+    }
+    return length;
+}
+
+void LineIndex::Private::indexLine(uint32_t row) {
+    const auto* data = reinterpret_cast<const unsigned char*>(source->data());
+    const size_t start = starts[row];
+    const size_t end = row + 1 < starts.size() ? starts[row + 1] - 1 : source->size();
+    uint32_t units = 0;
+    uint32_t codePoints = 0;
+
+    for (size_t i = start; i < end;) {
+        if (data[i] < 0x80) {
+            i++;
+            units++;
+            codePoints++;
+            continue;
+        }
+        WideChar c;
+        c.start[0] = static_cast<uint32_t>(i - start);
+        c.start[1] = units;
+        c.start[2] = codePoints;
+        c.bytes = sequenceLength(data + i, end - i);
+        c.units = c.bytes == 4 ? 2 : 1;
+        chars.push_back(c);
+        i += c.bytes;
+        units += c.units;
+        codePoints++;
+    }
+}
+
+void LineIndex::Private::indexWideChars() {
+    const char* data = source->data();
+    const size_t length = source->size();
+    size_t i = findNonAscii(data, 0, length);
+    if (i == length) {
+        return;
+    }
+
+    charEnds.assign(starts.size(), 0);
+    uint32_t row = 0;
+    while (i < length) {
+        const uint32_t next = static_cast<uint32_t>(
+            std::upper_bound(starts.begin() + row, starts.end(), i) - starts.begin());
+        for (; row + 1 < next; row++) {
+            charEnds[row] = static_cast<uint32_t>(chars.size());
+        }
+        indexLine(row);
+        charEnds[row] = static_cast<uint32_t>(chars.size());
+        row++;
+        if (row >= starts.size()) {
+            break;
+        }
+        i = findNonAscii(data, starts[row], length);
+    }
+    for (; row < starts.size(); row++) {
+        charEnds[row] = static_cast<uint32_t>(chars.size());
+    }
+    chars.shrink_to_fit();
+}
+
+/** Convert a column using the wide characters of its line. */
+static uint32_t mapColumn(const WideChar* begin, const WideChar* end,
+    uint32_t column, ColumnUnit from, ColumnUnit to)
+{
+    if (from == to) {
+        return column;
+    }
+    const int f = static_cast<int>(from);
+    const int t = static_cast<int>(to);
+    // The last wide character starting at or before the column; every
+    // character between it and the column is ASCII.
+    const WideChar* c = std::upper_bound(begin, end, column,
+        [f](uint32_t column, const WideChar& c) { return column < c.start[f]; });
+    if (c == begin) {
+        return column;
+    }
+    c--;
+    const uint32_t charEnd = c->start[f] + c->length(from);
+    if (column < charEnd) {
+        return c->start[t];
+    }
+    return c->start[t] + c->length(to) + (column - charEnd);
+}
+
+LineIndex::LineIndex(std::shared_ptr<const std::string> source)
+    : d(std::make_unique<Private>())
+{
+    d->source = source ? source : std::make_shared<const std::string>();
+    // Assume ~40 bytes per line to avoid most reallocations.
+    d->starts.reserve(d->source->size() / 40 + 1);
+    d->starts.push_back(0);
+    scanNewlines(d->source->data(), d->source->size(), d->starts);
+    d->starts.shrink_to_fit();
+    d->indexWideChars();
+}
+
+LineIndex::LineIndex(const std::string& source)
+    : LineIndex(std::make_shared<const std::string>(source)) { }
+
+LineIndex::LineIndex(const LineIndex& index)
+    : d(std::make_unique<Private>(*index.d)) { }
+
+LineIndex& LineIndex::operator=(const LineIndex &index) {
+    *d = *index.d;
+    return *this;
+}
+
+LineIndex::~LineIndex() = default;
+
+uint32_t LineIndex::lineCount() const {
+    return static_cast<uint32_t>(d->starts.size());
+}
+
+Index LineIndex::lineStart(uint32_t row) const {
+    if (row >= d->starts.size()) {
+        return static_cast<Index>(d->source->size());
+    }
+    return d->starts[row];
+}
+
+Index LineIndex::lineEnd(uint32_t row) const {
+    if (row + 1 >= d->starts.size()) {
+        return static_cast<Index>(d->source->size());
+    }
+    return d->starts[row + 1] - 1;
+}
+
+std::string_view LineIndex::line(uint32_t row) const {
+    if (row >= d->starts.size()) {
+        return {};
+    }
+    const Index start = lineStart(row);
+    Index end = lineEnd(row);
+    if (end > start && (*d->source)[end - 1] == '\r') {
+        end--;
+    }
+    return std::string_view(*d->source).substr(start, end - start);
+}
+
+Point LineIndex::offsetToPoint(Index offset) const {
+    offset = std::min<Index>(offset, static_cast<Index>(d->source->size()));
+    const auto it = std::upper_bound(d->starts.begin(), d->starts.end(), offset);
+    const uint32_t row = static_cast<uint32_t>(it - d->starts.begin()) - 1;
+    return Point { row, offset - d->starts[row] };
+}
+
+Index LineIndex::pointToOffset(Point point) const {
+    if (point.row >= d->starts.size()) {
+        return static_cast<Index>(d->source->size());
+    }
+    const uint64_t offset = uint64_t(d->starts[point.row]) + point.column;
+    return static_cast<Index>(std::min<uint64_t>(offset, lineEnd(point.row)));
+}
+
+bool LineIndex::isAscii(uint32_t row) const {
+    if (d->charEnds.empty() || row >= d->starts.size()) {
+        return true;
+    }
+    const uint32_t begin = row == 0 ? 0 : d->charEnds[row - 1];
+    return begin == d->charEnds[row];
+}
+
+uint32_t LineIndex::convertColumn(uint32_t row, uint32_t column,
+    ColumnUnit from, ColumnUnit to) const
+{
+    if (row >= d->starts.size()) {
+        return 0;
+    }
+    const uint32_t byteLength = lineEnd(row) - lineStart(row);
+    if (isAscii(row)) {
+        return std::min(column, byteLength);
+    }
+    const WideChar* begin = d->chars.data() + (row == 0 ? 0 : d->charEnds[row - 1]);
+    const WideChar* end = d->chars.data() + d->charEnds[row];
+    const uint32_t length = mapColumn(begin, end, byteLength, ColumnUnit::Bytes, from);
+    return mapColumn(begin, end, std::min(column, length), from, to);
+}
+
+Point LineIndex::convertPoint(Point point, ColumnUnit from, ColumnUnit to) const {
+    return Point { point.row, convertColumn(point.row, point.column, from, to) };
+}
+
+size_t LineIndex::memoryUsage() const {
+    return d->starts.capacity() * sizeof(Index)
+        + d->chars.capacity() * sizeof(WideChar)
+        + d->charEnds.capacity() * sizeof(uint32_t);
+}
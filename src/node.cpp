@@ -1,6 +1,10 @@
+#include <algorithm>
+#include <cstdlib>
 #include "tree_sitter/cxx/cursor.h"
 #include "tree_sitter/cxx/lang.h"
+#include "tree_sitter/cxx/lines.h"
 #include "tree_sitter/cxx/node.h"
+#include "tree_sitter/cxx/nodemap.h"
 #include "tree_sitter/cxx/tree.h"
 #include "tree_sitter/api.h"
 
@@ -10,77 +14,39 @@ static inline bool point_lte(TSPoint a, TSPoint b) {
     return (a.row < b.row) || (a.row == b.row && a.column <= b.column);
 }
 
-struct Node::Private {
-    const Tree* tree = nullptr;
-    TSNode node;
-    std::string text = "";
-    std::vector<Node> children = {};
-    std::vector<Node> namedChildren = {};
-    TSTreeCursor cursor = {0};
-};
-
-Node::Node(const Tree* tree, TSNode node)
-    : d(std::make_unique<Private>())
-{
-    d->tree = tree;
-    d->node = node;
-    const auto start = ts_node_start_byte(node);
-    const auto end = ts_node_end_byte(node);
-    const auto len = end - start;
-    const auto source = tree->source();
-    d->text = source.empty() ? "" : source.substr(start, len);
-}
-
-Node::Node(const Node& node)
-    : d(std::make_unique<Private>(*node.d)) { }
-
-Node& Node::operator=(const Node &node) {
-    *d = *node.d;
-    return *this;
-}
-
-bool Node::operator==(const Node &node) {
-    return ts_node_eq(d->node, d->node);
+bool Node::operator==(const Node &node) const {
+    return ts_node_eq(m_node, node.m_node);
 }
 
-bool Node::operator!=(Node node) {
-    return !ts_node_eq(d->node, d->node);
+bool Node::operator!=(const Node &node) const {
+    return !ts_node_eq(m_node, node.m_node);
 }
 
-Node::~Node() = default;
-
-#if 0
 uint64_t Node::id() const {
-    uint64_t ret = reinterpret_cast<const uint64_t>(d->node.id);
-    return ret;
-}
-#endif
-
-TSNode Node::node() const
-{
-    return d->node;
-}
-
-const Tree* Node::tree() const
-{
-    return d->tree;
+    return reinterpret_cast<uintptr_t>(m_node.id);
 }
 
 int Node::typeId() const {
-    return ts_node_symbol(d->node);
+    return ts_node_symbol(m_node);
 }
 
 std::string Node::type() const {
-    return ts_node_type(d->node);
+    return ts_node_type(m_node);
 }
 
 std::string Node::text() const {
-    return d->text;
+    const auto& source = m_tree->source();
+    const auto start = ts_node_start_byte(m_node);
+    const auto end = ts_node_end_byte(m_node);
+    if (start > end || end > source.size()) {
+        return "";
+    }
+    return source.substr(start, end - start);
 }
 
 Point Node::startPosition() const {
     Point point;
-    const auto pos = ts_node_start_point(d->node);
+    const auto pos = ts_node_start_point(m_node);
     point.row = pos.row;
     point.column = pos.column;
     return point;
@@ -88,209 +54,226 @@ Point Node::startPosition() const {
 
 Point Node::endPosition() const {
     Point point;
-    const auto pos = ts_node_end_point(d->node);
+    const auto pos = ts_node_end_point(m_node);
     point.row = pos.row;
     point.column = pos.column;
     return point;
 }
 
+Point Node::startPosition(ColumnUnit unit) const {
+    return m_tree->convertPoint(startPosition(), ColumnUnit::Bytes, unit);
+}
+
+Point Node::endPosition(ColumnUnit unit) const {
+    return m_tree->convertPoint(endPosition(), ColumnUnit::Bytes, unit);
+}
+
 Index Node::startIndex() const {
-    return ts_node_start_byte(d->node);
+    return ts_node_start_byte(m_node);
 }
 
 Index Node::endIndex() const {
-    return ts_node_end_byte(d->node);
+    return ts_node_end_byte(m_node);
 }
 
 Node Node::parent() const {
-    return Node(d->tree, ts_node_parent(d->node));
+    if (m_tree->parentIndexEnabled()) {
+        const auto index = m_tree->parentIndex();
+        const size_t i = index->nodes().indexOf(m_node);
+        if (i != NodeIndex::npos) {
+            const size_t parent = index->parentOf(i);
+            if (parent != NodeIndex::npos) {
+                return index->nodes().nodeAt(parent);
+            }
+        }
+    }
+    return Node(m_tree, ts_node_parent(m_node));
+}
+
+std::vector<Node> Node::ancestors() const {
+    std::vector<Node> result;
+    if (m_tree->parentIndexEnabled()) {
+        const auto index = m_tree->parentIndex();
+        size_t i = index->nodes().indexOf(m_node);
+        if (i != NodeIndex::npos) {
+            result.reserve(index->depthOf(i));
+            while ((i = index->parentOf(i)) != NodeIndex::npos) {
+                result.push_back(index->nodes().nodeAt(i));
+            }
+            return result;
+        }
+    }
+    for (TSNode node = ts_node_parent(m_node); !ts_node_is_null(node); node = ts_node_parent(node)) {
+        result.push_back(Node(m_tree, node));
+    }
+    return result;
+}
+
+uint32_t Node::depth() const {
+    if (m_tree->parentIndexEnabled()) {
+        const auto index = m_tree->parentIndex();
+        const size_t i = index->nodes().indexOf(m_node);
+        if (i != NodeIndex::npos) {
+            return index->depthOf(i);
+        }
+    }
+    uint32_t depth = 0;
+    for (TSNode node = ts_node_parent(m_node); !ts_node_is_null(node); node = ts_node_parent(node)) {
+        depth++;
+    }
+    return depth;
 }
 
 uint32_t Node::childCount() const {
-    return ts_node_child_count(d->node);
+    return ts_node_child_count(m_node);
 }
 
 std::vector<Node> Node::children() const {
-    if (d->children.size() > 0) {
-        return d->children;
-    }
-    uint32_t count = ts_node_child_count(d->node);
-    d->children.reserve(count);
-    if (count > 0) {
-        ts_tree_cursor_reset(&d->cursor, d->node);
-        const bool hasChildren = ts_tree_cursor_goto_first_child(&d->cursor);
-        if (!hasChildren) {
-            //TODO
-        }
-        TSNode node = ts_tree_cursor_current_node(&d->cursor);
-        d->children.push_back(Node(d->tree, node));
-        for (uint32_t i=1; i<count; i++) {
-            //TODO: handle ret.
-            ts_tree_cursor_goto_next_sibling(&d->cursor);
-            node = ts_tree_cursor_current_node(&d->cursor);
-            d->children.push_back(Node(d->tree, node));
-        }
+    std::vector<Node> result;
+    result.reserve(childCount());
+    for (Node child : childRange()) {
+        result.push_back(child);
     }
-    return d->children;
+    return result;
+}
+
+ChildRange Node::childRange() const {
+    return ChildRange(m_tree, m_node, false);
 }
 
 uint32_t Node::namedChildCount() const {
-    return ts_node_named_child_count(d->node);
+    return ts_node_named_child_count(m_node);
 }
 
 std::vector<Node> Node::namedChildren() const {
-    if (d->namedChildren.size() > 0) {
-        return d->namedChildren;
-    }
-    uint32_t count = ts_node_named_child_count(d->node);
-    d->namedChildren.reserve(count);
-    if (count > 0) {
-        ts_tree_cursor_reset(&d->cursor, d->node);
-        ts_tree_cursor_goto_first_child(&d->cursor);
-        uint32_t i = 0;
-        while (true) {
-            TSNode child = ts_tree_cursor_current_node(&d->cursor);
-            if (ts_node_is_named(child)) {
-                d->namedChildren.push_back(Node(d->tree, child));
-                i++;
-                if (i == count) {
-                    break;
-                }
-            }
-            if (!ts_tree_cursor_goto_next_sibling(&d->cursor)) {
-                break;
-            }
-        }
+    std::vector<Node> result;
+    result.reserve(namedChildCount());
+    for (Node child : namedChildRange()) {
+        result.push_back(child);
     }
-    return d->namedChildren;
+    return result;
+}
+
+ChildRange Node::namedChildRange() const {
+    return ChildRange(m_tree, m_node, true);
 }
 
 std::optional<Node> Node::firstChild() const {
-    if (children().size() == 0) {
-        return {};
-    }
-    return children().at(0);
+    return childRange().first();
 }
 
 std::optional<Node> Node::firstNamedChild() const {
-    if (namedChildren().size() == 0) {
-        return {};
-    }
-    return namedChildren().at(0);
+    return namedChildRange().first();
 }
 
 std::optional<Node> Node::lastChild() const {
-    if (children().size() == 0) {
-        return {};
-    }
-    return children().at(d->children.size() - 1);
+    return childRange().last();
 }
 
 std::optional<Node> Node::lastNamedChild() const {
-    if (namedChildren().size() == 0) {
-        return {};
-    }
-    return namedChildren().at(namedChildren().size() - 1);
+    return namedChildRange().last();
 }
 
 std::optional<Node> Node::nextSibling() const {
-    TSNode sibling = ts_node_next_sibling(d->node);
+    TSNode sibling = ts_node_next_sibling(m_node);
     if (ts_node_is_null(sibling)) {
         return {};
     }
-    return Node(d->tree, sibling);
+    return Node(m_tree, sibling);
 }
 
 std::optional<Node> Node::nextNamedSibling() const {
-    TSNode sibling = ts_node_next_named_sibling(d->node);
+    TSNode sibling = ts_node_next_named_sibling(m_node);
     if (ts_node_is_null(sibling)) {
         return {};
     }
-    return Node(d->tree, sibling);
+    return Node(m_tree, sibling);
 }
 
 std::optional<Node> Node::previousSibling() const {
-    TSNode sibling = ts_node_prev_sibling(d->node);
+    TSNode sibling = ts_node_prev_sibling(m_node);
     if (ts_node_is_null(sibling)) {
         return {};
     }
-    return Node(d->tree, sibling);
+    return Node(m_tree, sibling);
 }
 
 std::optional<Node> Node::previousNamedSibling() const {
-    TSNode sibling = ts_node_prev_named_sibling(d->node);
+    TSNode sibling = ts_node_prev_named_sibling(m_node);
     if (ts_node_is_null(sibling)) {
         return {};
     }
-    return Node(d->tree, sibling);
+    return Node(m_tree, sibling);
 }
 
 bool Node::hasChanges() {
-    return ts_node_has_changes(d->node);
+    return ts_node_has_changes(m_node);
 }
 
 bool Node::hasError() {
-    return ts_node_has_error(d->node);
+    return ts_node_has_error(m_node);
 }
 
 bool Node::equals(Node other) {
-    return ts_node_eq(d->node, other.d->node);
+    return ts_node_eq(m_node, other.m_node);
 }
 
 bool Node::isNamed() {
-    return ts_node_is_named(d->node);
+    return ts_node_is_named(m_node);
 }
 
 bool Node::isNull() {
-    return ts_node_is_null(d->node);
+    return ts_node_is_null(m_node);
 }
 
 bool Node::isMissing() {
-    return ts_node_is_missing(d->node);
+    return ts_node_is_missing(m_node);
 }
 
 std::string Node::sexpr() {
-    return ts_node_string(d->node);
+    char* str = ts_node_string(m_node);
+    std::string result(str);
+    free(str);
+    return result;
 }
 
 std::optional<Node> Node::child(int index) {
-    if (index < 0) {
-        //TODO: should an exception be thrown?
+    if (index < 0 || static_cast<uint32_t>(index) >= childCount()) {
+        //TODO: should an exception be thrown for negative indices?
         return {};
-    } else if (index >= children().size()) {
-        return {};
-    } else {
-        return children()[index];
     }
+    return Node(m_tree, ts_node_child(m_node, index));
 }
 
 std::optional<Node> Node::namedChild(int index) {
-    if (index < 0) {
-        //TODO: should an exception be thrown?
-        return {};
-    } else if (index >= namedChildren().size()) {
+    if (index < 0 || static_cast<uint32_t>(index) >= namedChildCount()) {
+        //TODO: should an exception be thrown for negative indices?
         return {};
-    } else {
-        return namedChildren()[index];
     }
+    return Node(m_tree, ts_node_named_child(m_node, index));
 }
 
 std::optional<Node> Node::childForFieldId(int fieldId) {
-    const auto child = ts_node_child_by_field_id(d->node, fieldId);
+    const auto child = ts_node_child_by_field_id(m_node, fieldId);
     if (ts_node_is_null(child)) {
         return {};
     }
-    return Node(d->tree, child);
+    return Node(m_tree, child);
 }
 
 std::optional<Node> Node::childForFieldName(const std::string& fieldName) {
-    const auto fields = d->tree->language().fields();
-    const auto it = std::find(fields.begin(), fields.end(), fieldName);
-    if (it == fields.end()) {
+    return childForField(m_tree->language().field(fieldName));
+}
+
+std::optional<Node> Node::childForField(FieldId field) const {
+    if (!field.valid()) {
+        return {};
+    }
+    const auto child = ts_node_child_by_field_id(m_node, field.id());
+    if (ts_node_is_null(child)) {
         return {};
     }
-    const auto fieldId = it - fields.begin();
-    return childForFieldId(fieldId);
+    return Node(m_tree, child);
 }
 
 Node Node::descendantForIndex(int index) {
@@ -300,21 +283,44 @@ Node Node::descendantForIndex(int index) {
 Node Node::descendantForIndex(int startIndex, int endIndex) {
     const auto start = startIndex;
     const auto end = endIndex > start ? start : endIndex;
-    const auto node = ts_node_descendant_for_byte_range(d->node, start, end);
-    return Node(d->tree, node);
+    const auto node = ts_node_descendant_for_byte_range(m_node, start, end);
+    return Node(m_tree, node);
+}
+
+/**
+ * Pre-order walk shared by the descendantsOfType() overloads.
+ * Subtrees for which `before` holds are skipped, and the walk stops at
+ * the first node for which `after` holds.
+ */
+template <typename Before, typename After, typename Visit>
+static void walkDescendantsOfType(Traversal& walk, const SymbolSet& symbols,
+    Before before, After after, Visit visit)
+{
+    while (walk.next()) {
+        const TSNode descendant = walk.current();
+
+        // If this node is before the selected range, then avoid
+        // descending into it.
+        if (before(descendant)) {
+            walk.skipSubtree();
+            continue;
+        }
+
+        // If this node is after the selected range, then stop walking.
+        if (after(descendant)) {
+            break;
+        }
+
+        // Report the node if its type matches one of the given node types.
+        if (symbols.contains(ts_node_symbol(descendant)) && !visit(descendant)) {
+            break;
+        }
+    }
 }
 
 std::vector<Node> Node::descendantsOfType(std::vector<std::string> types, Point startPosition, Point endPosition) {
     std::vector<Node> result;
-    std::vector<int> symbols;
-    const auto typesBySymbol = d->tree->language().nodeTypes();
-    const auto length = typesBySymbol.size();
-    for (int i=0; i<length; i++) {
-        const auto it = std::find(types.begin(), types.end(), typesBySymbol[i]);
-        if (it != types.end()) {
-            symbols.push_back(i);
-        }
-    }
+    const SymbolSet symbols = m_tree->language().symbolsForTypes(types);
 
     TSPoint start_point = { startPosition.row, startPosition.column };
     TSPoint end_point = { endPosition.row, endPosition.column };
@@ -323,60 +329,18 @@ std::vector<Node> Node::descendantsOfType(std::vector<std::string> types, Point
         end_point = TSPoint { UINT32_MAX, UINT32_MAX };
     }
 
-    ts_tree_cursor_reset(&d->cursor, d->node);
-
-    bool already_visited_children = false;
-    while (true) {
-        TSNode descendant = ts_tree_cursor_current_node(&d->cursor);
-
-        if (!already_visited_children) {
-            // If this node is before the selected range, then avoid
-            // descending into it.
-            if (point_lte(ts_node_end_point(descendant), start_point)) {
-                if (ts_tree_cursor_goto_next_sibling(&d->cursor)) {
-                    already_visited_children = false;
-                } else {
-                    if (!ts_tree_cursor_goto_parent(&d->cursor)) {
-                        break;
-                    }
-                    already_visited_children = true;
-                }
-                continue;
-            }
-
-            // If this node is after the selected range, then stop walking.
-            if (point_lte(end_point, ts_node_start_point(descendant))) {
-                break;
-            }
-
-            // Add the node to the result if its type matches one of the given
-            // node types.
-            const auto it = std::find(symbols.begin(), symbols.end(), ts_node_symbol(descendant));
-            if (it != symbols.end()) {
-                result.push_back(Node(d->tree, descendant));
-            }
-
-            // Continue walking.
-            if (ts_tree_cursor_goto_first_child(&d->cursor)) {
-                already_visited_children = false;
-            } else if (ts_tree_cursor_goto_next_sibling(&d->cursor)) {
-                already_visited_children = false;
-            } else {
-                if (!ts_tree_cursor_goto_parent(&d->cursor)) {
-                    break;
-                }
-                already_visited_children = true;
-            }
-        } else {
-            if (ts_tree_cursor_goto_next_sibling(&d->cursor)) {
-                already_visited_children = false;
-            } else {
-                if (!ts_tree_cursor_goto_parent(&d->cursor)) {
-                    break;
-                }
-            }
-        }
-    }
+    Traversal walk = descendants();
+    walkDescendantsOfType(walk, symbols,
+        [&start_point](TSNode node) {
+            return point_lte(ts_node_end_point(node), start_point);
+        },
+        [&end_point](TSNode node) {
+            return point_lte(end_point, ts_node_start_point(node));
+        },
+        [this, &result](TSNode node) {
+            result.push_back(Node(m_tree, node));
+            return true;
+        });
 
     return result;
 }
@@ -387,6 +351,33 @@ std::vector<Node> Node::descendantsOfType(std::string type, Point startPosition,
     return descendantsOfType(types, startPosition, endPosition);
 }
 
+std::vector<Node> Node::descendantsOfType(const SymbolSet& symbols, Index startIndex, Index endIndex) const {
+    std::vector<Node> result;
+    visitDescendantsOfType(symbols, [&result](const Node& node) {
+        result.push_back(node);
+        return true;
+    }, startIndex, endIndex);
+    return result;
+}
+
+void Node::visitDescendantsOfType(const SymbolSet& symbols,
+    const std::function<bool (const Node& node)>& callback,
+    Index startIndex, Index endIndex) const
+{
+    Traversal walk = descendants();
+    walkDescendantsOfType(walk, symbols,
+        [startIndex](TSNode node) {
+            return ts_node_start_byte(node) < startIndex
+                && ts_node_end_byte(node) <= startIndex;
+        },
+        [endIndex](TSNode node) {
+            return ts_node_start_byte(node) >= endIndex;
+        },
+        [this, &callback](TSNode node) {
+            return callback(Node(m_tree, node));
+        });
+}
+
 Node Node::namedDescendantForIndex(int index) {
     return namedDescendantForIndex(index, index);
 }
@@ -395,8 +386,8 @@ Node Node::namedDescendantForIndex(int startIndex, int endIndex) {
     if (endIndex < startIndex) {
         endIndex = startIndex;
     }
-    const auto node = ts_node_named_descendant_for_byte_range(d->node, startIndex, endIndex);
-    return Node(d->tree, node);
+    const auto node = ts_node_named_descendant_for_byte_range(m_node, startIndex, endIndex);
+    return Node(m_tree, node);
 }
 
 Node Node::descendantForPosition(Point position) {
@@ -404,8 +395,8 @@ Node Node::descendantForPosition(Point position) {
 }
 
 Node Node::descendantForPosition(Point startPosition, Point endPosition) {
-    const auto node = ts_node_descendant_for_point_range(d->node, startPosition, endPosition);
-    return Node(d->tree, node);
+    const auto node = ts_node_descendant_for_point_range(m_node, startPosition, endPosition);
+    return Node(m_tree, node);
 }
 
 Node Node::namedDescendantForPosition(Point position) {
@@ -413,11 +404,15 @@ Node Node::namedDescendantForPosition(Point position) {
 }
 
 Node Node::namedDescendantForPosition(Point start, Point end) {
-    auto descendant = ts_node_named_descendant_for_point_range(d->node, start, end);
-    return Node(d->tree, descendant);
+    auto descendant = ts_node_named_descendant_for_point_range(m_node, start, end);
+    return Node(m_tree, descendant);
+}
+
+Traversal Node::descendants(Traversal::Order order, bool namedOnly) const {
+    return Traversal(m_tree, m_node, order, namedOnly);
 }
 
 Cursor Node::walk() {
-    TSTreeCursor cursor = ts_tree_cursor_new(d->node);
-    return Cursor(d->tree, cursor);
+    TSTreeCursor cursor = ts_tree_cursor_new(m_node);
+    return Cursor(m_tree, cursor);
 }
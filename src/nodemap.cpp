@@ -0,0 +1,166 @@
+#include <cstdint>
+#include "tree_sitter/api.h"
+#include "tree_sitter/cxx/nodemap.h"
+#include "tree_sitter/cxx/traversal.h"
+#include "tree_sitter/cxx/tree.h"
+
+using namespace TreeSitter;
+
+struct NodeIndex::Private {
+    const Tree* tree = nullptr;
+    /** Every node, in pre-order. */
+    std::vector<TSNode> nodes = {};
+    /** Open-addressing table of node IDs, 0 marks an empty slot. */
+    std::vector<uintptr_t> keys = {};
+    /** Pre-order position for each slot of `keys`. */
+    std::vector<uint32_t> values = {};
+    unsigned shift = 64;
+
+    size_t slotFor(uintptr_t key) const {
+        return static_cast<size_t>((uint64_t(key) * 0x9e3779b97f4a7c15ULL) >> shift);
+    }
+};
+
+NodeIndex::NodeIndex(const Tree* tree)
+    : d(std::make_unique<Private>())
+{
+    d->tree = tree;
+    Traversal walk = tree->rootNode().descendants();
+    while (walk.next()) {
+        d->nodes.push_back(walk.current());
+    }
+    d->nodes.shrink_to_fit();
+
+    // Keep the load factor at or below 50%.
+    unsigned bits = 4;
+    while ((size_t(1) << bits) < d->nodes.size() * 2) {
+        bits++;
+    }
+    d->shift = 64 - bits;
+    d->keys.assign(size_t(1) << bits, 0);
+    d->values.assign(size_t(1) << bits, 0);
+
+    const size_t mask = d->keys.size() - 1;
+    for (size_t i=0; i<d->nodes.size(); i++) {
+        const uintptr_t key = reinterpret_cast<uintptr_t>(d->nodes[i].id);
+        size_t slot = d->slotFor(key);
+        while (d->keys[slot] != 0 && d->keys[slot] != key) {
+            slot = (slot + 1) & mask;
+        }
+        d->keys[slot] = key;
+        d->values[slot] = static_cast<uint32_t>(i);
+    }
+}
+
+NodeIndex::NodeIndex(const NodeIndex& index)
+    : d(std::make_unique<Private>(*index.d)) { }
+
+NodeIndex& NodeIndex::operator=(const NodeIndex &index) {
+    *d = *index.d;
+    return *this;
+}
+
+NodeIndex::~NodeIndex() = default;
+
+size_t NodeIndex::size() const {
+    return d->nodes.size();
+}
+
+size_t NodeIndex::indexOf(const Node& node) const {
+    return indexOf(node.node());
+}
+
+size_t NodeIndex::indexOf(TSNode node) const {
+    const uintptr_t key = reinterpret_cast<uintptr_t>(node.id);
+    if (key == 0 || d->nodes.empty() || node.tree != d->nodes[0].tree) {
+        return npos;
+    }
+    const size_t mask = d->keys.size() - 1;
+    for (size_t slot = d->slotFor(key); d->keys[slot] != 0; slot = (slot + 1) & mask) {
+        if (d->keys[slot] == key) {
+            return d->values[slot];
+        }
+    }
+    return npos;
+}
+
+Node NodeIndex::nodeAt(size_t index) const {
+    return Node(d->tree, d->nodes.at(index));
+}
+
+TSNode NodeIndex::rawNodeAt(size_t index) const {
+    return d->nodes.at(index);
+}
+
+size_t NodeIndex::memoryUsage() const {
+    return d->nodes.capacity() * sizeof(TSNode)
+        + d->keys.capacity() * sizeof(uintptr_t)
+        + d->values.capacity() * sizeof(uint32_t);
+}
+
+struct ParentIndex::Private {
+    std::shared_ptr<const NodeIndex> nodes = nullptr;
+    std::vector<uint32_t> parents = {};
+    std::vector<uint32_t> depths = {};
+};
+
+static constexpr uint32_t NO_PARENT = UINT32_MAX;
+
+ParentIndex::ParentIndex(std::shared_ptr<const NodeIndex> nodes)
+    : d(std::make_unique<Private>())
+{
+    d->nodes = nodes;
+    d->parents.reserve(nodes->size());
+    d->depths.reserve(nodes->size());
+
+    // The walk visits nodes in the same order they were numbered, so
+    // the position of the latest node at each depth is its children's
+    // parent.
+    std::vector<uint32_t> path;
+    Traversal walk = nodes->nodeAt(0).descendants();
+    for (auto it = walk.begin(); it != walk.end(); ++it) {
+        const uint32_t depth = it.depth();
+        const uint32_t index = static_cast<uint32_t>(d->parents.size());
+        path.resize(depth);
+        d->parents.push_back(depth == 0 ? NO_PARENT : path[depth - 1]);
+        d->depths.push_back(depth);
+        path.push_back(index);
+    }
+}
+
+ParentIndex::ParentIndex(const ParentIndex& index)
+    : d(std::make_unique<Private>(*index.d)) { }
+
+ParentIndex& ParentIndex::operator=(const ParentIndex &index) {
+    *d = *index.d;
+    return *this;
+}
+
+ParentIndex::~ParentIndex() = default;
+
+const NodeIndex& ParentIndex::nodes() const {
+    return *d->nodes;
+}
+
+size_t ParentIndex::parentOf(size_t index) const {
+    const uint32_t parent = d->parents.at(index);
+    return parent == NO_PARENT ? NodeIndex::npos : parent;
+}
+
+uint32_t ParentIndex::depthOf(size_t index) const {
+    return d->depths.at(index);
+}
+
+std::optional<Node> ParentIndex::parent(const Node& node) const {
+    const size_t index = d->nodes->indexOf(node);
+    if (index == NodeIndex::npos || d->parents[index] == NO_PARENT) {
+        return {};
+    }
+    return d->nodes->nodeAt(d->parents[index]);
+}
+
+size_t ParentIndex::memoryUsage() const {
+    return d->nodes->memoryUsage()
+        + d->parents.capacity() * sizeof(uint32_t)
+        + d->depths.capacity() * sizeof(uint32_t);
+}
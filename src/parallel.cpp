@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "tree_sitter/api.h"
+#include "tree_sitter/cxx/lang.h"
+#include "tree_sitter/cxx/node.h"
+#include "tree_sitter/cxx/parallel.h"
+#include "tree_sitter/cxx/traversal.h"
+#include "tree_sitter/cxx/tree.h"
+
+using namespace TreeSitter;
+
+static constexpr Index DEFAULT_PARTITION_SIZE = 64 * 1024;
+
+namespace {
+
+struct Partition {
+    TSNode node;
+    /** `false` if only the node itself belongs to this partition. */
+    bool wholeSubtree;
+};
+
+/** The same node, in another copy of its tree. */
+TSNode inTree(TSNode node, const TSTree* tree) {
+    node.tree = tree;
+    return node;
+}
+
+}
+
+struct ParallelTraversal::Private {
+    const Tree* tree = nullptr;
+    unsigned threads = 1;
+    std::vector<Partition> partitions = {};
+
+    void split(const Node& root, Index budget);
+    void run(const std::function<void (TSNode node, size_t partition)>& fn,
+        bool namedOnly) const;
+    std::vector<Node> merge(const std::vector<std::vector<TSNode>>& found) const;
+};
+
+void ParallelTraversal::Private::split(const Node& root, Index budget) {
+    Traversal walk = root.descendants();
+    while (walk.next()) {
+        const TSNode node = walk.current();
+        const Index size = ts_node_end_byte(node) - ts_node_start_byte(node);
+        if (size <= budget || ts_node_child_count(node) == 0) {
+            partitions.push_back({ node, true });
+            walk.skipSubtree();
+        } else {
+            partitions.push_back({ node, false });
+        }
+    }
+}
+
+void ParallelTraversal::Private::run(
+    const std::function<void (TSNode node, size_t partition)>& fn,
+    bool namedOnly) const
+{
+    std::atomic<size_t> nextPartition(0);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    const auto worker = [&]() {
+        // A TSTree must not be used by several threads at once; copies
+        // are cheap and share the nodes.
+        const std::unique_ptr<TSTree, decltype(&ts_tree_delete)> copy(ts_tree_copy(tree->tree()), ts_tree_delete);
+        try {
+            size_t index;
+            while ((index = nextPartition++) < partitions.size()) {
+                const Partition& partition = partitions[index];
+                const TSNode node = inTree(partition.node, copy.get());
+                if (!partition.wholeSubtree) {
+                    if (!namedOnly || ts_node_is_named(node)) {
+                        fn(node, index);
+                    }
+                    continue;
+                }
+                Traversal walk(tree, node, Traversal::PreOrder, namedOnly);
+                while (walk.next()) {
+                    fn(walk.current(), index);
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            nextPartition = partitions.size();
+        }
+    };
+
+    const size_t threadCount = std::min<size_t>(threads, partitions.size());
+    std::vector<std::thread> pool;
+    for (size_t i=1; i<threadCount; i++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/** Concatenate the nodes found per partition, moved back to the tree from the copies. */
+std::vector<Node> ParallelTraversal::Private::merge(const std::vector<std::vector<TSNode>>& found) const {
+    std::vector<Node> result;
+    for (const auto& nodes : found) {
+        for (const TSNode node : nodes) {
+            result.push_back(Node(tree, inTree(node, tree->tree())));
+        }
+    }
+    return result;
+}
+
+ParallelTraversal::ParallelTraversal(const Node& root, Options options)
+    : d(std::make_unique<Private>())
+{
+    d->tree = root.tree();
+    d->threads = options.threads > 0
+        ? options.threads
+        : std::max(1u, std::thread::hardware_concurrency());
+
+    // Aim for a few partitions per thread so that uneven subtrees
+    // still balance out.
+    const Index minSize = options.minPartitionSize > 0
+        ? options.minPartitionSize
+        : DEFAULT_PARTITION_SIZE;
+    const Index size = root.endIndex() - root.startIndex();
+    const Index budget = std::max<Index>(minSize, size / (d->threads * 4));
+    d->split(root, budget);
+}
+
+ParallelTraversal::ParallelTraversal(const ParallelTraversal& traversal)
+    : d(std::make_unique<Private>(*traversal.d)) { }
+
+ParallelTraversal& ParallelTraversal::operator=(const ParallelTraversal &traversal) {
+    *d = *traversal.d;
+    return *this;
+}
+
+ParallelTraversal::~ParallelTraversal() = default;
+
+unsigned ParallelTraversal::threadCount() const {
+    return static_cast<unsigned>(std::min<size_t>(d->threads, d->partitions.size()));
+}
+
+size_t ParallelTraversal::partitionCount() const {
+    return d->partitions.size();
+}
+
+void ParallelTraversal::visit(const Visitor& visitor, bool namedOnly) const {
+    const Tree* tree = d->tree;
+    d->run([tree, &visitor](TSNode node, size_t partition) {
+        visitor(Node(tree, node), partition);
+    }, namedOnly);
+}
+
+std::vector<Node> ParallelTraversal::collect(
+    const std::function<bool (const Node& node)>& predicate,
+    bool namedOnly) const
+{
+    const Tree* tree = d->tree;
+    std::vector<std::vector<TSNode>> found(d->partitions.size());
+    d->run([tree, &predicate, &found](TSNode node, size_t partition) {
+        if (predicate(Node(tree, node))) {
+            found[partition].push_back(node);
+        }
+    }, namedOnly);
+    return d->merge(found);
+}
+
+std::vector<Node> ParallelTraversal::descendantsOfType(const SymbolSet& symbols) const {
+    std::vector<std::vector<TSNode>> found(d->partitions.size());
+    d->run([&symbols, &found](TSNode node, size_t partition) {
+        if (symbols.contains(ts_node_symbol(node))) {
+            found[partition].push_back(node);
+        }
+    }, false);
+    return d->merge(found);
+}
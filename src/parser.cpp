@@ -52,6 +52,22 @@ void Parser::setLanguage(Language lang) {
     ts_parser_set_language(d->parser, d->lang.language());
 }
 
+std::vector<Range> Parser::includedRanges() const {
+    uint32_t count;
+    const TSRange* ranges = ts_parser_included_ranges(d->parser, &count);
+    // The whole input is reported as a single unbounded range.
+    if (count == 1 && ranges[0].start_byte == 0 && ranges[0].end_byte == UINT32_MAX) {
+        return {};
+    }
+    return std::vector<Range>(ranges, ranges + count);
+}
+
+void Parser::setIncludedRanges(const std::vector<Range>& ranges) {
+    if (!ts_parser_set_included_ranges(d->parser, ranges.data(), static_cast<uint32_t>(ranges.size()))) {
+        throw std::invalid_argument("Included ranges must be ordered and must not overlap");
+    }
+}
+
 Logger Parser::logger() const {
     return d->logger;
 }
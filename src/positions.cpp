@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <cstdint>
+#include "tree_sitter/api.h"
+#include "tree_sitter/cxx/positions.h"
+#include "tree_sitter/cxx/traversal.h"
+#include "tree_sitter/cxx/tree.h"
+
+using namespace TreeSitter;
+
+namespace {
+
+struct Segment {
+    Point start;
+    /** Position in `nodes` of the smallest node covering the segment. */
+    uint32_t node;
+    /** Position in `nodes` of the smallest named node covering the segment. */
+    uint32_t named;
+};
+
+struct Open {
+    Point end;
+    uint32_t node;
+    uint32_t named;
+};
+
+inline bool pointBefore(Point a, Point b) {
+    return a.row < b.row || (a.row == b.row && a.column < b.column);
+}
+
+}
+
+struct PositionIndex::Private {
+    const Tree* tree = nullptr;
+    /** Every non-empty node, in pre-order. Index 0 is the root. */
+    std::vector<TSNode> nodes = {};
+    /** Consecutive segments, sorted by start. */
+    std::vector<Segment> segments = {};
+
+    void close(Point end, const Open& owner);
+    size_t find(Point position) const;
+    size_t advance(size_t segment, Point position) const;
+    std::vector<Node> findAll(const std::vector<Point>& positions, bool named) const;
+};
+
+void PositionIndex::Private::close(Point end, const Open& owner) {
+    // Start the next segment at `end`, unless it would be empty. The
+    // previous segment is replaced rather than left empty.
+    if (!segments.empty() && !pointBefore(segments.back().start, end)) {
+        segments.back().node = owner.node;
+        segments.back().named = owner.named;
+        return;
+    }
+    if (!segments.empty() && segments.back().node == owner.node) {
+        return;
+    }
+    segments.push_back({ end, owner.node, owner.named });
+}
+
+size_t PositionIndex::Private::find(Point position) const {
+    const auto it = std::upper_bound(segments.begin(), segments.end(), position,
+        [](const Point& position, const Segment& segment) { return pointBefore(position, segment.start); });
+    return it - segments.begin();
+}
+
+size_t PositionIndex::Private::advance(size_t segment, Point position) const {
+    if (segment > 0 && pointBefore(position, segments[segment - 1].start)) {
+        return find(position);
+    }
+    while (segment < segments.size() && !pointBefore(position, segments[segment].start)) {
+        segment++;
+    }
+    return segment;
+}
+
+std::vector<Node> PositionIndex::Private::findAll(
+    const std::vector<Point>& positions, bool named) const
+{
+    std::vector<Node> result;
+    result.reserve(positions.size());
+    size_t segment = 0;
+    for (const Point& position : positions) {
+        // `segment` is one past the segment containing the position.
+        segment = advance(segment, position);
+        uint32_t node = 0;
+        if (segment > 0) {
+            node = named ? segments[segment - 1].named : segments[segment - 1].node;
+        }
+        result.push_back(Node(tree, nodes[node]));
+    }
+    return result;
+}
+
+PositionIndex::PositionIndex(const Tree* tree)
+    : d(std::make_unique<Private>())
+{
+    d->tree = tree;
+    const Node root = tree->rootNode();
+    d->nodes.push_back(root.node());
+    d->segments.push_back({ root.startPosition(), 0, 0 });
+
+    // Walk the tree keeping the chain of nodes that contain the current
+    // position. Every node start and end closes the segment before it.
+    std::vector<Open> open;
+    open.push_back({ root.endPosition(), 0, 0 });
+    Traversal walk = root.descendants();
+    walk.next();
+    while (walk.next()) {
+        const TSNode node = walk.current();
+        const Point start = ts_node_start_point(node);
+        const Point end = ts_node_end_point(node);
+        if (!pointBefore(start, end)) {
+            walk.skipSubtree();
+            continue;
+        }
+        while (!pointBefore(start, open.back().end)) {
+            const Open closed = open.back();
+            open.pop_back();
+            d->close(closed.end, open.back());
+        }
+        const uint32_t index = static_cast<uint32_t>(d->nodes.size());
+        d->nodes.push_back(node);
+        const Open opened = { end, index, ts_node_is_named(node) ? index : open.back().named };
+        d->close(start, opened);
+        open.push_back(opened);
+    }
+    while (open.size() > 1) {
+        const Open closed = open.back();
+        open.pop_back();
+        d->close(closed.end, open.back());
+    }
+    // Positions at or past the end of the root belong to the root.
+    d->close(root.endPosition(), { root.endPosition(), 0, 0 });
+    d->nodes.shrink_to_fit();
+    d->segments.shrink_to_fit();
+}
+
+PositionIndex::PositionIndex(const PositionIndex& index)
+    : d(std::make_unique<Private>(*index.d)) { }
+
+PositionIndex& PositionIndex::operator=(const PositionIndex &index) {
+    *d = *index.d;
+    return *this;
+}
+
+PositionIndex::~PositionIndex() = default;
+
+Node PositionIndex::descendantForPosition(Point position) const {
+    const size_t segment = d->find(position);
+    return Node(d->tree, d->nodes[segment == 0 ? 0 : d->segments[segment - 1].node]);
+}
+
+Node PositionIndex::namedDescendantForPosition(Point position) const {
+    const size_t segment = d->find(position);
+    return Node(d->tree, d->nodes[segment == 0 ? 0 : d->segments[segment - 1].named]);
+}
+
+std::vector<Node> PositionIndex::descendantsForPositions(const std::vector<Point>& positions) const {
+    return d->findAll(positions, false);
+}
+
+std::vector<Node> PositionIndex::namedDescendantsForPositions(const std::vector<Point>& positions) const {
+    return d->findAll(positions, true);
+}
+
+size_t PositionIndex::segmentCount() const {
+    return d->segments.size();
+}
+
+size_t PositionIndex::memoryUsage() const {
+    return d->nodes.capacity() * sizeof(TSNode)
+        + d->segments.capacity() * sizeof(Segment);
+}
@@ -1,43 +1,420 @@
+#include <algorithm>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "tree_sitter/cxx/cursor.h"
 #include "tree_sitter/cxx/lang.h"
 #include "tree_sitter/cxx/node.h"
 #include "tree_sitter/cxx/query.h"
+#include "tree_sitter/cxx/tree.h"
 #include "tree_sitter/api.h"
+#include "query_p.h"
 
 using namespace TreeSitter;
+using namespace TreeSitter::Internal;
+
+namespace {
+
+/**
+ * Capture names are interned for the lifetime of the program, so that
+ * captures can hold a view of their name that outlives the query.
+ * Queries use few distinct names, so the table stays small.
+ */
+std::string_view internName(std::string_view name) {
+    static std::mutex mutex;
+    static std::unordered_set<std::string> names;
+    std::lock_guard<std::mutex> lock(mutex);
+    return *names.insert(std::string(name)).first;
+}
 
-struct Query::Private {
-    TSQuery* query;
-    TSQueryCursor* cursor;
-    std::vector<std::string> captureNames;
-    std::vector<std::vector<TextPredicate>> textPredicates;
-    std::vector<std::vector<PredicateResult>> predicates;
-    std::vector<Properties> setProperties;
-    std::vector<Properties> assertedProperties;
-    std::vector<Properties> refutedProperties;
-    bool exceededMatchLimit;
+/** The text of a node, without copying it. */
+std::string_view nodeText(const Tree* tree, TSNode node) {
+    const std::string& source = tree->source();
+    const uint32_t start = ts_node_start_byte(node);
+    const uint32_t end = ts_node_end_byte(node);
+    if (start > end || end > source.size()) {
+        return {};
+    }
+    return std::string_view(source).substr(start, end - start);
+}
+
+/** The index of the next capture of `index` at or after `i`, or `count`. */
+uint32_t nextCapture(const TSQueryCapture* captures, uint32_t count, uint32_t index, uint32_t i) {
+    while (i < count && captures[i].index != index) {
+        i++;
+    }
+    return i;
+}
+
+void checkArgumentCount(const std::string& op, size_t steps, size_t min, size_t max) {
+    if (steps < min || steps > max) {
+        throw std::range_error("Wrong number of arguments to `#" + op + "` predicate");
+    }
+}
+
+struct PredicateRegistry {
+    std::mutex mutex;
+    std::unordered_map<std::string, Query::Predicate> predicates;
+    /** Number of registrations so far. */
+    uint64_t generation = 0;
 };
 
-Query::Query(
+PredicateRegistry& predicateRegistry() {
+    static PredicateRegistry registry;
+    return registry;
+}
+
+std::optional<Query::Predicate> registeredPredicate(const std::string& name) {
+    PredicateRegistry& registry = predicateRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    const auto it = registry.predicates.find(name);
+    if (it == registry.predicates.end()) {
+        return {};
+    }
+    return it->second;
+}
+
+/** A string of the query, owned by the TSQuery. */
+std::string_view queryString(const TSQuery* query, uint32_t id) {
+    uint32_t length;
+    const char* value = ts_query_string_value_for_id(query, id, &length);
+    return std::string_view(value, length);
+}
+
+/** Add one predicate of `pattern`; `steps` excludes the final Done step. */
+void compilePredicate(
+    CompiledQuery& query,
+    uint32_t pattern,
+    const std::vector<TSQueryPredicateStep>& steps,
+    const std::vector<std::string>& strings)
+{
+    if (steps[0].type != TSQueryPredicateStepTypeString) {
+        throw std::range_error("Predicates must begin with a literal value");
+    }
+    const std::string& op = strings[steps[0].value_id];
+    const auto isCapture = [&steps](size_t i) {
+        return steps[i].type == TSQueryPredicateStepTypeCapture;
+    };
+
+    // `any-not-eq?` is `eq?` with the `any` and `not` flags.
+    PredicateOp predicate;
+    std::string name = op;
+    predicate.any = name != "any-of?" && name.compare(0, 4, "any-") == 0;
+    if (predicate.any) {
+        name.erase(0, 4);
+    }
+    predicate.positive = name.compare(0, 4, "not-") != 0;
+    if (!predicate.positive) {
+        name.erase(0, 4);
+    }
+
+    if (name == "eq?" || name == "match?") {
+        checkArgumentCount(op, steps.size(), 3, 3);
+        if (!isCapture(1)) {
+            throw std::range_error("First argument of `#" + op + "` predicate must be a capture");
+        }
+        predicate.capture = steps[1].value_id;
+        if (name == "match?") {
+            if (isCapture(2)) {
+                throw std::range_error("Second argument of `#" + op + "` predicate must be a string");
+            }
+            predicate.kind = PredicateOp::Match;
+            predicate.operand = static_cast<uint32_t>(query.regexes.size());
+            query.regexes.emplace_back(strings[steps[2].value_id]);
+        } else if (isCapture(2)) {
+            predicate.kind = PredicateOp::EqCapture;
+            predicate.operand = steps[2].value_id;
+        } else {
+            predicate.kind = PredicateOp::EqString;
+            predicate.operand = static_cast<uint32_t>(query.strings.size());
+            query.strings.push_back(strings[steps[2].value_id]);
+        }
+        query.textPredicates[pattern].push_back(predicate);
+        return;
+    }
+
+    if (name == "any-of?") {
+        if (steps.size() < 3) {
+            throw std::range_error("Wrong number of arguments to `#" + op + "` predicate");
+        }
+        if (!isCapture(1)) {
+            throw std::range_error("First argument of `#" + op + "` predicate must be a capture");
+        }
+        std::unordered_set<std::string_view> values;
+        for (size_t i=2; i<steps.size(); i++) {
+            if (isCapture(i)) {
+                throw std::range_error("Arguments to `#" + op + "` predicate must be strings");
+            }
+            values.insert(queryString(query.query, steps[i].value_id));
+        }
+        predicate.kind = PredicateOp::AnyOf;
+        predicate.capture = steps[1].value_id;
+        predicate.operand = static_cast<uint32_t>(query.stringSets.size());
+        query.stringSets.push_back(std::move(values));
+        query.textPredicates[pattern].push_back(predicate);
+        return;
+    }
+
+    if (op == "set!" || op == "is?" || op == "is-not?") {
+        checkArgumentCount(op, steps.size(), 2, 3);
+        for (size_t i=1; i<steps.size(); i++) {
+            if (isCapture(i)) {
+                throw std::range_error("Arguments to `#" + op + "` predicate must be a strings");
+            }
+        }
+        Query::Properties& properties = op == "set!" ? query.setProperties[pattern]
+            : op == "is?" ? query.assertedProperties[pattern]
+            : query.refutedProperties[pattern];
+        properties[strings[steps[1].value_id]] = steps.size() == 3 ? strings[steps[2].value_id] : "";
+        return;
+    }
+
+    if (auto custom = registeredPredicate(op)) {
+        std::vector<Query::Argument> arguments;
+        for (size_t i=1; i<steps.size(); i++) {
+            if (isCapture(i)) {
+                arguments.push_back({ true, steps[i].value_id, query.captureNames[steps[i].value_id] });
+            } else {
+                arguments.push_back({ false, 0, queryString(query.query, steps[i].value_id) });
+            }
+        }
+        predicate.kind = PredicateOp::Custom;
+        predicate.positive = true;
+        predicate.any = false;
+        predicate.capture = 0;
+        predicate.operand = static_cast<uint32_t>(query.customPredicates.size());
+        query.customPredicates.push_back({ std::move(*custom), std::move(arguments) });
+        query.textPredicates[pattern].push_back(predicate);
+        return;
+    }
+
+    std::vector<Query::Operand> operands;
+    for (size_t i=1; i<steps.size(); i++) {
+        if (isCapture(i)) {
+            operands.push_back({ std::string(query.captureNames[steps[i].value_id]), "capture" });
+        } else {
+            operands.push_back({ strings[steps[i].value_id], "string" });
+        }
+    }
+    query.predicates[pattern].push_back({ op, operands });
+}
+
+}
+
+Internal::CompiledQuery::~CompiledQuery() {
+    ts_query_delete(query);
+}
+
+bool Internal::CompiledQuery::satisfies(
+    const Tree* tree,
+    uint32_t pattern,
+    const TSQueryCapture* captures,
+    uint32_t count) const
+{
+    for (const PredicateOp& op : textPredicates[pattern]) {
+        if (op.kind == PredicateOp::Custom) {
+            const CustomPredicate& custom = customPredicates[op.operand];
+            if (!custom.predicate(Query::MatchView(tree, pattern, captures, count), custom.arguments)) {
+                return false;
+            }
+            continue;
+        }
+
+        // The plain forms fail on the first node that does not hold;
+        // the `any-` forms succeed on the first node that does.
+        bool found = false;
+        if (op.kind == PredicateOp::EqCapture) {
+            // Compare the nodes of both captures pairwise.
+            uint32_t i = nextCapture(captures, count, op.capture, 0);
+            uint32_t j = nextCapture(captures, count, op.operand, 0);
+            while (i < count && j < count && !(op.any && found)) {
+                const bool holds = (nodeText(tree, captures[i].node) == nodeText(tree, captures[j].node)) == op.positive;
+                if (!holds && !op.any) {
+                    return false;
+                }
+                found = holds;
+                i = nextCapture(captures, count, op.capture, i + 1);
+                j = nextCapture(captures, count, op.operand, j + 1);
+            }
+        } else {
+            for (uint32_t i = nextCapture(captures, count, op.capture, 0); i < count && !(op.any && found);
+                i = nextCapture(captures, count, op.capture, i + 1))
+            {
+                const std::string_view text = nodeText(tree, captures[i].node);
+                bool result;
+                switch (op.kind) {
+                case PredicateOp::EqString: result = text == strings[op.operand]; break;
+                case PredicateOp::Match: result = regexes[op.operand].search(text); break;
+                default: result = stringSets[op.operand].count(text) != 0; break;
+                }
+                const bool holds = result == op.positive;
+                if (!holds && !op.any) {
+                    return false;
+                }
+                found = holds;
+            }
+        }
+        if (op.any && !found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::shared_ptr<const CompiledQuery> Internal::compileQuery(
     TSQuery* query,
-    std::vector<std::string> captureNames,
-    std::vector<std::vector<TextPredicate>> textPredicates,
-    std::vector<std::vector<PredicateResult>> predicates,
-    std::vector<Properties> setProperties,
-    std::vector<Properties> assertedProperties,
-    std::vector<Properties> refutedProperties
-)
+    const TSLanguage* language,
+    const std::string& source)
+{
+    auto compiled = std::make_shared<CompiledQuery>();
+    compiled->query = query;
+    compiled->language = language;
+    compiled->source = source;
+
+    const uint32_t captureCount = ts_query_capture_count(query);
+    const uint32_t stringCount = ts_query_string_count(query);
+    const uint32_t patternCount = ts_query_pattern_count(query);
+
+    compiled->captureNames.reserve(captureCount);
+    for (uint32_t i=0; i<captureCount; i++) {
+        uint32_t length;
+        const char* name = ts_query_capture_name_for_id(query, i, &length);
+        compiled->captureNames.push_back(internName(std::string_view(name, length)));
+    }
+    std::vector<std::string> strings;
+    strings.reserve(stringCount);
+    for (uint32_t i=0; i<stringCount; i++) {
+        uint32_t length;
+        const char* value = ts_query_string_value_for_id(query, i, &length);
+        strings.emplace_back(value, length);
+    }
+
+    compiled->textPredicates.resize(patternCount);
+    compiled->predicates.resize(patternCount);
+    compiled->setProperties.resize(patternCount);
+    compiled->assertedProperties.resize(patternCount);
+    compiled->refutedProperties.resize(patternCount);
+
+    std::vector<TSQueryPredicateStep> predicate;
+    for (uint32_t pattern=0; pattern<patternCount; pattern++) {
+        uint32_t stepCount;
+        const TSQueryPredicateStep* steps = ts_query_predicates_for_pattern(query, pattern, &stepCount);
+        for (uint32_t i=0; i<stepCount; i++) {
+            if (steps[i].type != TSQueryPredicateStepTypeDone) {
+                predicate.push_back(steps[i]);
+            } else if (!predicate.empty()) {
+                compilePredicate(*compiled, pattern, predicate, strings);
+                predicate.clear();
+            }
+        }
+        predicate.clear();
+    }
+    return compiled;
+}
+
+uint64_t Internal::predicateGeneration() {
+    PredicateRegistry& registry = predicateRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return registry.generation;
+}
+
+struct Query::Private {
+    /** Shared by every copy of the query. */
+    std::shared_ptr<const CompiledQuery> compiled;
+};
+
+struct QueryCursor::Private {
+    TSQueryCursor* cursor = ts_query_cursor_new();
+    uint32_t matchLimit = 0;
+    Index startByte = 0;
+    Index endByte = 0;
+    Point startPoint = { 0, 0 };
+    Point endPoint = { 0, 0 };
+
+    /** The query of the current run; keeps it alive until the next exec(). */
+    std::shared_ptr<const CompiledQuery> query;
+    const Tree* tree = nullptr;
+    /** The current match, reused from one step to the next. */
+    Query::Match match;
+
+    Private() = default;
+    Private(const Private&) = delete;
+    Private& operator=(const Private&) = delete;
+    ~Private() {
+        ts_query_cursor_delete(cursor);
+    }
+
+    void fill(const TSQueryMatch& raw);
+    bool accept(const TSQueryMatch& raw) const {
+        return query->satisfies(tree, raw.pattern_index, raw.captures, raw.capture_count);
+    }
+
+    /** Clear the settings and the run, keeping the cursor and the match buffer. */
+    void reset() {
+        matchLimit = 0;
+        startByte = 0;
+        endByte = 0;
+        startPoint = { 0, 0 };
+        endPoint = { 0, 0 };
+        query.reset();
+        tree = nullptr;
+    }
+
+    /** Cursor states released on this thread, ready for reuse. */
+    struct Pool {
+        /** Released states beyond this are deleted. */
+        static constexpr size_t CAPACITY = 4;
+
+        std::vector<std::unique_ptr<Private>> states;
+
+        ~Pool() {
+            destroyed() = true;
+        }
+
+        /** Set once the pool of this thread is gone; cursors destroyed later are not pooled. */
+        static bool& destroyed() {
+            thread_local bool value = false;
+            return value;
+        }
+
+        static Pool& get() {
+            thread_local Pool pool;
+            return pool;
+        }
+    };
+
+    static std::unique_ptr<Private> acquire() {
+        if (!Pool::destroyed()) {
+            auto& states = Pool::get().states;
+            if (!states.empty()) {
+                std::unique_ptr<Private> state = std::move(states.back());
+                states.pop_back();
+                return state;
+            }
+        }
+        return std::make_unique<Private>();
+    }
+
+    static void release(std::unique_ptr<Private> state) {
+        if (Pool::destroyed()) {
+            return;
+        }
+        auto& states = Pool::get().states;
+        if (states.size() < Pool::CAPACITY) {
+            state->reset();
+            states.push_back(std::move(state));
+        }
+    }
+};
+
+Query::Query(std::shared_ptr<const CompiledQuery> compiled)
     : d(std::make_unique<Private>())
 {
-    d->query = query;
-    d->captureNames = captureNames;
-    d->textPredicates = textPredicates;
-    d->predicates = predicates;
-    d->setProperties = setProperties;
-    d->assertedProperties = assertedProperties;
-    d->refutedProperties = refutedProperties;
-    d->exceededMatchLimit = false;
-    d->cursor = ts_query_cursor_new();
+    d->compiled = std::move(compiled);
 }
 
 Query::Query(const Query& query)
@@ -48,221 +425,209 @@ Query& Query::operator=(const Query &query) {
     return *this;
 }
 
-Query::~Query() {
-    ts_query_cursor_delete(d->cursor);
-    ts_query_delete(d->query);
-}
+Query::~Query() = default;
 
 std::vector<std::string> Query::captureNames() const {
-    return d->captureNames;
+    const auto& names = d->compiled->captureNames;
+    return std::vector<std::string>(names.begin(), names.end());
 }
 
-struct MatchResult {
-    uint32_t pattern;
-    uint32_t captureCount;
-    uint32_t captureIndex;
-    std::vector<TSQueryCapture> captures;
-};
+Language Query::language() const {
+    return Language(d->compiled->language);
+}
 
-// ts_query_matches_wasm
-static std::tuple<uint32_t, std::vector<MatchResult>, bool> queryMatches(
-    TSQuery* query,
-    TSQueryCursor* cursor,
-  Node node,
-  uint32_t start_row,
-  uint32_t start_column,
-  uint32_t end_row,
-  uint32_t end_column,
-  uint32_t match_limit
-) {
-    if (match_limit == 0) {
-        ts_query_cursor_set_match_limit(cursor, UINT32_MAX);
-    } else {
-        ts_query_cursor_set_match_limit(cursor, match_limit);
+const std::string& Query::source() const {
+    return d->compiled->source;
+}
+
+uint32_t Query::patternCount() const {
+    return ts_query_pattern_count(d->compiled->query);
+}
+
+uint32_t Query::captureCount() const {
+    return static_cast<uint32_t>(d->compiled->captureNames.size());
+}
+
+std::string_view Query::captureName(uint32_t index) const {
+    const auto& names = d->compiled->captureNames;
+    return index < names.size() ? names[index] : std::string_view();
+}
+
+std::optional<uint32_t> Query::captureIndex(std::string_view name) const {
+    const auto& names = d->compiled->captureNames;
+    const auto it = std::find(names.begin(), names.end(), name);
+    if (it == names.end()) {
+        return {};
     }
+    return static_cast<uint32_t>(it - names.begin());
+}
+
+std::vector<Query::Match> Query::matches(Node node, Point startPosition, Point endPosition, Options options) const {
+    QueryCursor cursor;
+    cursor.setMatchLimit(options.matchLimit);
+    cursor.setPointRange(startPosition, endPosition);
+    return cursor.matches(*this, node);
+}
 
-  TSPoint start_point = { start_row, start_column };
-  TSPoint end_point = { end_row, end_column };
-  ts_query_cursor_set_point_range(cursor, start_point, end_point);
-  ts_query_cursor_exec(cursor, query, node.node());
-
-  uint32_t index = 0;
-  uint32_t match_count = 0;
-  TSQueryMatch match;
-  std::vector<MatchResult> results;
-
-  while (ts_query_cursor_next_match(cursor, &match)) {
-    match_count++;
-    MatchResult result;
-    result.pattern = match.pattern_index;
-    result.captureCount = match.capture_count;
-    for (uint32_t i=0; i<match.capture_count; i++) {
-        const TSQueryCapture *capture = &match.captures[i];
-        TSQueryCapture c = { capture->node, capture->index };
-        result.captures.push_back(c);
+std::vector<Query::Capture> Query::captures(Node node, Point startPosition, Point endPosition, Options options) const {
+    QueryCursor cursor;
+    cursor.setMatchLimit(options.matchLimit);
+    cursor.setPointRange(startPosition, endPosition);
+    return cursor.captures(*this, node);
+}
+
+void Query::registerPredicate(const std::string& name, Predicate predicate) {
+    PredicateRegistry& registry = predicateRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.predicates[name] = std::move(predicate);
+    registry.generation++;
+}
+
+std::string_view Query::MatchView::text(uint32_t i) const {
+    return nodeText(m_tree, m_captures[i].node);
+}
+
+uint32_t Query::MatchView::find(uint32_t capture, uint32_t from) const {
+    return nextCapture(m_captures, m_count, capture, from);
+}
+
+std::vector<Query::PredicateResult> Query::predicatesForPattern(int patternIndex) const {
+    if (patternIndex < 0 || static_cast<size_t>(patternIndex) >= d->compiled->predicates.size()) {
+        return {};
     }
-    results.push_back(result);
-  }
+    return d->compiled->predicates[patternIndex];
+}
 
-  bool did_exceed_match_limit =
-    ts_query_cursor_did_exceed_match_limit(cursor);
-  return std::make_tuple(match_count, results, did_exceed_match_limit);
+static const Query::Properties& patternProperties(const std::vector<Query::Properties>& properties, uint32_t pattern) {
+    static const Query::Properties empty;
+    return pattern < properties.size() ? properties[pattern] : empty;
 }
 
-static std::tuple<uint32_t, std::vector<MatchResult>, bool> queryCaptures(
-    TSQuery* query,
-    TSQueryCursor* cursor,
-    Node node,
-  uint32_t start_row,
-  uint32_t start_column,
-  uint32_t end_row,
-  uint32_t end_column,
-  uint32_t match_limit
-) {
-  if (match_limit == 0) {
-    ts_query_cursor_set_match_limit(cursor, UINT32_MAX);
-  } else {
-    ts_query_cursor_set_match_limit(cursor, match_limit);
-  }
-
-  TSPoint start_point = { start_row, start_column };
-  TSPoint end_point = { end_row, end_column };
-  ts_query_cursor_set_point_range(cursor, start_point, end_point);
-  ts_query_cursor_exec(cursor, query, node.node());
-
-  uint32_t index = 0;
-  uint32_t capture_count = 0;
-  TSQueryMatch match;
-  uint32_t capture_index;
-  std::vector<MatchResult> result;
-
-  while (ts_query_cursor_next_capture(
-    cursor,
-    &match,
-    &capture_index
-  )) {
-    capture_count++;
-    MatchResult matchResult;
-    matchResult.pattern = match.pattern_index;
-    matchResult.captureCount = match.capture_count;
-    matchResult.captureIndex = capture_index;
-    for (uint32_t i=0; i<match.capture_count; i++) {
-        const TSQueryCapture *capture = &match.captures[i];
-        TSQueryCapture c = { capture->node, capture->index };
-        matchResult.captures.push_back(c);
+const Query::Properties& Query::setProperties(uint32_t pattern) const {
+    return patternProperties(d->compiled->setProperties, pattern);
+}
+
+const Query::Properties& Query::assertedProperties(uint32_t pattern) const {
+    return patternProperties(d->compiled->assertedProperties, pattern);
+}
+
+const Query::Properties& Query::refutedProperties(uint32_t pattern) const {
+    return patternProperties(d->compiled->refutedProperties, pattern);
+}
+
+QueryCursor::QueryCursor()
+    : d(Private::acquire()) { }
+
+QueryCursor::~QueryCursor() {
+    Private::release(std::move(d));
+}
+
+void QueryCursor::setMatchLimit(uint32_t limit) {
+    d->matchLimit = limit;
+}
+
+void QueryCursor::setByteRange(Index start, Index end) {
+    d->startByte = start;
+    d->endByte = end;
+}
+
+void QueryCursor::setPointRange(Point start, Point end) {
+    d->startPoint = start;
+    d->endPoint = end;
+}
+
+bool QueryCursor::didExceedMatchLimit() const {
+    return ts_query_cursor_did_exceed_match_limit(d->cursor);
+}
+
+void QueryCursor::Private::fill(const TSQueryMatch& raw) {
+    match.pattern = raw.pattern_index;
+    auto& captures = match.captures;
+    if (captures.size() > raw.capture_count) {
+        captures.erase(captures.begin() + raw.capture_count, captures.end());
     }
-    result.push_back(matchResult);
-  }
-
-  bool did_exceed_match_limit =
-    ts_query_cursor_did_exceed_match_limit(cursor);
-  return std::make_tuple(capture_count, result, did_exceed_match_limit);
-}
-
-std::vector<Query::Match> Query::matches(Node node, Point startPosition, Point endPosition, Options options) {
-    const uint32_t matchLimit = options.matchLimit;
-    //std::vector<Match> result;
-
-    auto ret = queryMatches(
-        d->query,
-        d->cursor,
-        node,
-      startPosition.row,
-      startPosition.column,
-      endPosition.row,
-      endPosition.column,
-      matchLimit
-    );
-
-    uint32_t rawCount = std::get<0>(ret);
-    std::vector<MatchResult> matchResults = std::get<1>(ret);
-    bool didExceedMatchLimit = std::get<2>(ret);
-    std::vector<Match> result(rawCount);
-
-    d->exceededMatchLimit = didExceedMatchLimit;
-    auto tree = node.tree();
-
-    for (uint32_t i=0; i<rawCount; i++) {
-        const uint32_t pattern = matchResults[i].pattern;
-        const uint32_t captureCount = matchResults[i].captureCount;
-        std::vector<Capture> captures;
-        captures.reserve(captureCount);
-
-        for (int j=0; j<captureCount; j++) {
-            TSQueryCapture capture = matchResults[i].captures.at(j);
-            std::string name = d->captureNames[capture.index];
-            Node n(tree, capture.node);
-            captures.push_back({ name, n });
+    for (uint32_t i=0; i<raw.capture_count; i++) {
+        const TSQueryCapture& capture = raw.captures[i];
+        const std::string_view name = query->captureNames[capture.index];
+        if (i < captures.size()) {
+            captures[i].index = capture.index;
+            captures[i].name = name;
+            captures[i].node = Node(tree, capture.node);
+        } else {
+            captures.push_back({ capture.index, name, Node(tree, capture.node) });
         }
+    }
+}
 
-        bool every = true;
-        for (auto fn : d->textPredicates[pattern]) {
-            if (!fn(captures)) {
-                every = false;
-                break;
-            }
+void QueryCursor::exec(const Query& query, const Node& node) {
+    d->query = query.d->compiled;
+    d->tree = node.tree();
+    // Pooled cursors keep the settings of their last run.
+    ts_query_cursor_set_match_limit(d->cursor, d->matchLimit == 0 ? UINT32_MAX : d->matchLimit);
+    ts_query_cursor_set_byte_range(d->cursor, d->startByte, d->endByte == 0 ? UINT32_MAX : d->endByte);
+    ts_query_cursor_set_point_range(d->cursor, d->startPoint, d->endPoint);
+    ts_query_cursor_exec(d->cursor, d->query->query, node.node());
+}
+
+const Query::Match* QueryCursor::nextMatch() {
+    if (!d->query) {
+        return nullptr;
+    }
+    TSQueryMatch raw;
+    while (ts_query_cursor_next_match(d->cursor, &raw)) {
+        if (d->accept(raw)) {
+            d->fill(raw);
+            return &d->match;
         }
-        if (every) {
-            result.push_back({ pattern, captures });
+    }
+    return nullptr;
+}
+
+const Query::Capture* QueryCursor::nextCapture() {
+    if (!d->query) {
+        return nullptr;
+    }
+    TSQueryMatch raw;
+    uint32_t captureIndex;
+    while (ts_query_cursor_next_capture(d->cursor, &raw, &captureIndex)) {
+        if (d->accept(raw)) {
+            d->fill(raw);
+            return &d->match.captures[captureIndex];
         }
+        // Otherwise every later capture of the match comes back, and it
+        // keeps counting against the match limit.
+        ts_query_cursor_remove_match(d->cursor, raw.id);
     }
+    return nullptr;
+}
 
-    result.shrink_to_fit();
+const Query::Match& QueryCursor::currentMatch() const {
+    return d->match;
+}
 
-    return result;
+QueryCursor::MatchRange QueryCursor::eachMatch(const Query& query, const Node& node) {
+    exec(query, node);
+    return MatchRange(this);
 }
 
-std::vector<Query::Capture> Query::captures(Node node, Point startPosition, Point endPosition, Options options) {
-    uint32_t matchLimit = options.matchLimit;
-
-    auto ret = queryCaptures(
-        d->query,
-        d->cursor,
-        node,
-      startPosition.row,
-      startPosition.column,
-      endPosition.row,
-      endPosition.column,
-      matchLimit
-    );
-    uint32_t count = std::get<0>(ret);
-    std::vector<MatchResult> matchResults = std::get<1>(ret);
-    const bool didExceedMatchLimit = std::get<2>(ret);
-    std::vector<Capture> result;
-    d->exceededMatchLimit = didExceedMatchLimit;
-    auto tree = node.tree();
-
-    for (uint32_t i=0; i<count; i++) {
-        const uint32_t pattern = matchResults[i].pattern;
-        const uint32_t captureCount = matchResults[i].captureCount;
-        const uint32_t captureIndex = matchResults[i].captureIndex;
-        std::vector<Capture> captures;
-
-        for (auto c : matchResults[i].captures) {
-            std::string name = d->captureNames[c.index];
-            Node n(tree, c.node);
-            captures.push_back({ name, n });
-        }
+QueryCursor::CaptureRange QueryCursor::eachCapture(const Query& query, const Node& node) {
+    exec(query, node);
+    return CaptureRange(this);
+}
 
-        bool every = true;
-        for (auto fn : d->textPredicates[pattern]) {
-            if (!fn(captures)) {
-                every = false;
-                break;
-            }
-        }
-        if (every) {
-            Capture capture = captures[captureIndex];
-            result.push_back(capture);
-        }
+std::vector<Query::Match> QueryCursor::matches(const Query& query, const Node& node) {
+    std::vector<Query::Match> result;
+    for (const Query::Match& match : eachMatch(query, node)) {
+        result.push_back(match);
     }
-
     return result;
 }
 
-std::vector<Query::PredicateResult> Query::predicatesForPattern(int patternIndex) {
-    if (patternIndex >= d->predicates.size()) {
-        return {};
+std::vector<Query::Capture> QueryCursor::captures(const Query& query, const Node& node) {
+    std::vector<Query::Capture> result;
+    for (const Query::Capture& capture : eachCapture(query, node)) {
+        result.push_back(capture);
     }
-    return d->predicates[patternIndex];
+    return result;
 }
+
@@ -0,0 +1,93 @@
+/**
+ * @file query_p.h
+ * @brief Compiled query data shared by Language, Query and QueryCursor.
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include "tree_sitter/api.h"
+#include "tree_sitter/cxx/query.h"
+#include "regex.h"
+
+namespace TreeSitter {
+
+class Tree;
+
+namespace Internal {
+
+/** One text predicate, checked against the captures of a match. */
+struct PredicateOp {
+    enum Kind : uint8_t {
+        /** `#eq? @capture "string"`; the operand indexes CompiledQuery.strings. */
+        EqString,
+        /** `#eq? @capture @other`; the operand is the other capture. */
+        EqCapture,
+        /** `#match? @capture "regex"`; the operand indexes CompiledQuery.regexes. */
+        Match,
+        /** `#any-of? @capture "a" "b"`; the operand indexes CompiledQuery.stringSets. */
+        AnyOf,
+        /** A registered predicate; the operand indexes CompiledQuery.customPredicates. */
+        Custom,
+    };
+
+    Kind kind;
+    /** `false` for the `not-` variants. */
+    bool positive;
+    /** `true` if one node of the capture is enough (`#any-` variants). */
+    bool any;
+    /** The capture tested. */
+    uint32_t capture;
+    uint32_t operand;
+};
+
+/** A registered predicate with its arguments, as used in one pattern. */
+struct CustomPredicate {
+    Query::Predicate predicate;
+    std::vector<Query::Argument> arguments;
+};
+
+/** Everything produced by compiling a query; never changed afterwards. */
+struct CompiledQuery {
+    TSQuery* query = nullptr;
+    const TSLanguage* language = nullptr;
+    std::string source;
+    /** Interned, indexed by capture ID. */
+    std::vector<std::string_view> captureNames;
+    /** Text predicates, per pattern. */
+    std::vector<std::vector<PredicateOp>> textPredicates;
+    std::vector<std::string> strings;
+    std::vector<Regex> regexes;
+    /** Views of strings owned by `query`. */
+    std::vector<std::unordered_set<std::string_view>> stringSets;
+    std::vector<CustomPredicate> customPredicates;
+    /** Predicates the query does not evaluate itself, per pattern. */
+    std::vector<std::vector<Query::PredicateResult>> predicates;
+    std::vector<Query::Properties> setProperties;
+    std::vector<Query::Properties> assertedProperties;
+    std::vector<Query::Properties> refutedProperties;
+
+    CompiledQuery() = default;
+    CompiledQuery(const CompiledQuery&) = delete;
+    CompiledQuery& operator=(const CompiledQuery&) = delete;
+    ~CompiledQuery();
+
+    /** Returns `true` if the captures of a match satisfy the text predicates of its pattern. */
+    bool satisfies(const Tree* tree, uint32_t pattern, const TSQueryCapture* captures, uint32_t count) const;
+};
+
+/**
+ * @brief Read the captures and predicates of `query`, taking ownership of it.
+ *
+ * @throws std::range_error If a predicate is malformed.
+ */
+std::shared_ptr<const CompiledQuery> compileQuery(TSQuery* query, const TSLanguage* language, const std::string& source);
+
+/** Changes whenever a predicate is registered, so caches can tell stale queries apart. */
+uint64_t predicateGeneration();
+
+}
+}
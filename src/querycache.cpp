@@ -0,0 +1,127 @@
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include "tree_sitter/api.h"
+#include "tree_sitter/cxx/querycache.h"
+#include "query_p.h"
+
+using namespace TreeSitter;
+
+namespace {
+
+struct Key {
+    const TSLanguage* lang;
+    std::string source;
+    /** Queries compiled before a predicate was registered do not evaluate it. */
+    uint64_t generation;
+    size_t hash;
+
+    bool operator==(const Key& key) const {
+        return lang == key.lang && hash == key.hash && generation == key.generation && source == key.source;
+    }
+};
+
+struct KeyHash {
+    size_t operator()(const Key& key) const { return key.hash; }
+};
+
+struct Entry {
+    Key key;
+    Query query;
+};
+
+size_t hashKey(const TSLanguage* lang, std::string_view source, uint64_t generation) {
+    size_t h = std::hash<std::string_view>()(source);
+    h ^= std::hash<const void*>()(lang) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h ^ (std::hash<uint64_t>()(generation) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2));
+}
+
+}
+
+struct QueryCache::Private {
+    mutable std::mutex mutex;
+    size_t capacity = 0;
+    /** Most recently used first. */
+    std::list<Entry> entries;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+
+    void evict() {
+        while (entries.size() > capacity) {
+            index.erase(entries.back().key);
+            entries.pop_back();
+            evictions++;
+        }
+    }
+};
+
+QueryCache::QueryCache(size_t capacity)
+    : d(std::make_unique<Private>())
+{
+    d->capacity = capacity;
+}
+
+QueryCache::~QueryCache() = default;
+
+QueryCache& QueryCache::global() {
+    static QueryCache cache;
+    return cache;
+}
+
+Query QueryCache::get(const Language& lang, const std::string& source) {
+    const uint64_t generation = Internal::predicateGeneration();
+    Key key = { lang.language(), source, generation, hashKey(lang.language(), source, generation) };
+    {
+        std::lock_guard<std::mutex> lock(d->mutex);
+        const auto it = d->index.find(key);
+        if (it != d->index.end()) {
+            d->hits++;
+            d->entries.splice(d->entries.begin(), d->entries, it->second);
+            return it->second->query;
+        }
+        d->misses++;
+    }
+
+    Query query = Language(lang).query(source);
+
+    std::lock_guard<std::mutex> lock(d->mutex);
+    const auto it = d->index.find(key);
+    if (it != d->index.end()) {
+        // Another thread compiled it first; share that one.
+        d->entries.splice(d->entries.begin(), d->entries, it->second);
+        return it->second->query;
+    }
+    if (d->capacity == 0) {
+        return query;
+    }
+    d->entries.push_front({ key, query });
+    d->index.emplace(std::move(key), d->entries.begin());
+    d->evict();
+    return query;
+}
+
+QueryCache::Stats QueryCache::stats() const {
+    std::lock_guard<std::mutex> lock(d->mutex);
+    return Stats { d->hits, d->misses, d->evictions, d->entries.size() };
+}
+
+size_t QueryCache::capacity() const {
+    std::lock_guard<std::mutex> lock(d->mutex);
+    return d->capacity;
+}
+
+void QueryCache::setCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->capacity = capacity;
+    d->evict();
+}
+
+void QueryCache::clear() {
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->index.clear();
+    d->entries.clear();
+}
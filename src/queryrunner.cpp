@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include "tree_sitter/cxx/node.h"
+#include "tree_sitter/cxx/parser.h"
+#include "tree_sitter/cxx/queryrunner.h"
+#include "tree_sitter/cxx/tree.h"
+
+using namespace TreeSitter;
+
+namespace {
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot read file " + path);
+    }
+    std::ostringstream content;
+    content << file.rdbuf();
+    if (file.bad()) {
+        throw std::runtime_error("Cannot read file " + path);
+    }
+    return content.str();
+}
+
+}
+
+struct QueryRunner::Private {
+    Query query;
+    unsigned threads = 1;
+
+    using Task = std::function<void (size_t input, const Tree& tree, QueryCursor& cursor, unsigned thread)>;
+
+    void run(const std::vector<Input>& inputs, const Task& task) const;
+};
+
+void QueryRunner::Private::run(const std::vector<Input>& inputs, const Task& task) const {
+    std::atomic<size_t> nextInput(0);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    const auto worker = [&](unsigned thread) {
+        try {
+            QueryCursor cursor;
+            std::optional<Parser> parser;
+            size_t index;
+            while ((index = nextInput++) < inputs.size()) {
+                const Input& input = inputs[index];
+                if (input.tree != nullptr) {
+                    task(index, *input.tree, cursor, thread);
+                    continue;
+                }
+                if (!parser) {
+                    parser.emplace();
+                    parser->setLanguage(query.language());
+                }
+                const Tree tree = parser->parse(readFile(input.path));
+                task(index, tree, cursor, thread);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            nextInput = inputs.size();
+        }
+    };
+
+    const unsigned threadCount = static_cast<unsigned>(std::min<size_t>(threads, inputs.size()));
+    std::vector<std::thread> pool;
+    for (unsigned i=1; i<threadCount; i++) {
+        pool.emplace_back(worker, i);
+    }
+    worker(0);
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+std::vector<QueryRunner::Input> QueryRunner::fromTrees(const std::vector<Tree>& trees) {
+    std::vector<Input> inputs;
+    inputs.reserve(trees.size());
+    for (const Tree& tree : trees) {
+        inputs.push_back({ &tree, "" });
+    }
+    return inputs;
+}
+
+std::vector<QueryRunner::Input> QueryRunner::fromFiles(const std::vector<std::string>& paths) {
+    std::vector<Input> inputs;
+    inputs.reserve(paths.size());
+    for (const std::string& path : paths) {
+        inputs.push_back({ nullptr, path });
+    }
+    return inputs;
+}
+
+QueryRunner::QueryRunner(const Query& query, Options options)
+    : d(std::make_unique<Private>(Private { query }))
+{
+    d->threads = options.threads > 0
+        ? options.threads
+        : std::max(1u, std::thread::hardware_concurrency());
+}
+
+QueryRunner::QueryRunner(const QueryRunner& runner)
+    : d(std::make_unique<Private>(*runner.d)) { }
+
+QueryRunner& QueryRunner::operator=(const QueryRunner &runner) {
+    *d = *runner.d;
+    return *this;
+}
+
+QueryRunner::~QueryRunner() = default;
+
+unsigned QueryRunner::threadCount() const {
+    return d->threads;
+}
+
+void QueryRunner::visit(const std::vector<Input>& inputs, const Visitor& visitor) const {
+    const Query& query = d->query;
+    d->run(inputs, [&query, &visitor](size_t input, const Tree& tree, QueryCursor& cursor, unsigned thread) {
+        for (const Query::Match& match : cursor.eachMatch(query, tree.rootNode())) {
+            visitor(input, match, thread);
+        }
+    });
+}
+
+std::vector<QueryRunner::Capture> QueryRunner::captures(const std::vector<Input>& inputs) const {
+    // Every input gets its own list, written by one thread only.
+    std::vector<std::vector<Capture>> perInput(inputs.size());
+    const Query& query = d->query;
+    d->run(inputs, [&query, &perInput](size_t input, const Tree& tree, QueryCursor& cursor, unsigned) {
+        std::vector<Capture>& result = perInput[input];
+        for (const Query::Capture& capture : cursor.eachCapture(query, tree.rootNode())) {
+            const TSNode node = capture.node.node();
+            result.push_back({
+                input,
+                cursor.currentMatch().pattern,
+                capture.index,
+                ts_node_start_byte(node),
+                ts_node_end_byte(node),
+                ts_node_start_point(node),
+                ts_node_end_point(node),
+            });
+        }
+    });
+
+    size_t total = 0;
+    for (const auto& captures : perInput) {
+        total += captures.size();
+    }
+    std::vector<Capture> result;
+    result.reserve(total);
+    for (auto& captures : perInput) {
+        std::move(captures.begin(), captures.end(), std::back_inserter(result));
+    }
+    return result;
+}
+
+std::vector<uint64_t> QueryRunner::countCaptures(const std::vector<Input>& inputs) const {
+    const size_t captureCount = d->query.captureCount();
+    return reduce(inputs, std::vector<uint64_t>(captureCount, 0),
+        [](std::vector<uint64_t>& counts, size_t, const Query::Match& match) {
+            for (const Query::Capture& capture : match.captures) {
+                counts[capture.index]++;
+            }
+        },
+        [](std::vector<uint64_t>& counts, std::vector<uint64_t>&& other) {
+            for (size_t i=0; i<counts.size(); i++) {
+                counts[i] += other[i];
+            }
+        });
+}
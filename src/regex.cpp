@@ -0,0 +1,660 @@
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <map>
+#include <optional>
+#include "regex.h"
+
+using namespace TreeSitter::Internal;
+
+/** Larger DFAs fall back to std::regex. */
+static constexpr size_t MAX_DFA_STATES = 2048;
+/** Larger NFAs (mostly from counted repetition) fall back to std::regex. */
+static constexpr size_t MAX_NFA_STATES = 4096;
+static constexpr int UNBOUNDED = -1;
+
+namespace {
+
+using ByteSet = std::bitset<256>;
+
+struct AstNode {
+    enum Kind { Set, Concat, Alt, Repeat, Begin, End };
+    Kind kind;
+    ByteSet set;
+    std::vector<int> children;
+    int min = 0;
+    int max = 0;
+};
+
+/**
+ * Parses the subset of ECMAScript syntax the DFA supports. Returns
+ * nothing for anything else, valid or not; std::regex sorts those out.
+ */
+class Parser {
+public:
+    explicit Parser(const std::string& pattern) : m_pattern(pattern) { }
+
+    std::optional<int> parse() {
+        const auto root = alternation();
+        if (!root || m_pos != m_pattern.size()) {
+            return {};
+        }
+        return root;
+    }
+
+    std::vector<AstNode> nodes;
+private:
+    int add(AstNode node) {
+        nodes.push_back(std::move(node));
+        return static_cast<int>(nodes.size() - 1);
+    }
+
+    int addSet(const ByteSet& set) {
+        AstNode node { AstNode::Set };
+        node.set = set;
+        return add(node);
+    }
+
+    bool atEnd() const { return m_pos >= m_pattern.size(); }
+    char peek() const { return m_pattern[m_pos]; }
+
+    std::optional<int> alternation() {
+        std::vector<int> branches;
+        while (true) {
+            const auto branch = concatenation();
+            if (!branch) {
+                return {};
+            }
+            branches.push_back(*branch);
+            if (atEnd() || peek() != '|') {
+                break;
+            }
+            m_pos++;
+        }
+        if (branches.size() == 1) {
+            return branches[0];
+        }
+        AstNode node { AstNode::Alt };
+        node.children = std::move(branches);
+        return add(node);
+    }
+
+    std::optional<int> concatenation() {
+        AstNode node { AstNode::Concat };
+        while (!atEnd() && peek() != '|' && peek() != ')') {
+            const auto item = repetition();
+            if (!item) {
+                return {};
+            }
+            node.children.push_back(*item);
+        }
+        return add(node);
+    }
+
+    std::optional<int> repetition() {
+        auto atom = this->atom();
+        while (atom && !atEnd()) {
+            int min;
+            int max;
+            const char c = peek();
+            if (c == '*') {
+                min = 0;
+                max = UNBOUNDED;
+                m_pos++;
+            } else if (c == '+') {
+                min = 1;
+                max = UNBOUNDED;
+                m_pos++;
+            } else if (c == '?') {
+                min = 0;
+                max = 1;
+                m_pos++;
+            } else if (c == '{') {
+                if (!counted(min, max)) {
+                    return {};
+                }
+            } else {
+                break;
+            }
+            // Laziness does not change whether there is a match.
+            if (!atEnd() && peek() == '?') {
+                m_pos++;
+            }
+            const AstNode::Kind kind = nodes[*atom].kind;
+            if (kind == AstNode::Begin || kind == AstNode::End) {
+                return {};
+            }
+            AstNode node { AstNode::Repeat };
+            node.children = { *atom };
+            node.min = min;
+            node.max = max;
+            atom = add(node);
+        }
+        return atom;
+    }
+
+    /** `{n}`, `{n,}` or `{n,m}`. */
+    bool counted(int& min, int& max) {
+        m_pos++;
+        const auto first = number();
+        if (!first || atEnd()) {
+            return false;
+        }
+        min = *first;
+        max = min;
+        if (peek() == ',') {
+            m_pos++;
+            max = UNBOUNDED;
+            if (!atEnd() && peek() != '}') {
+                const auto second = number();
+                if (!second || *second < min) {
+                    return false;
+                }
+                max = *second;
+            }
+        }
+        if (atEnd() || peek() != '}') {
+            return false;
+        }
+        m_pos++;
+        return true;
+    }
+
+    std::optional<int> number() {
+        int value = 0;
+        const size_t start = m_pos;
+        while (!atEnd() && peek() >= '0' && peek() <= '9' && value < 1000) {
+            value = value * 10 + (peek() - '0');
+            m_pos++;
+        }
+        if (m_pos == start || value >= 1000) {
+            return {};
+        }
+        return value;
+    }
+
+    std::optional<int> atom() {
+        const char c = peek();
+        m_pos++;
+        switch (c) {
+        case '(': {
+            if (!atEnd() && peek() == '?') {
+                if (m_pattern.compare(m_pos, 2, "?:") != 0) {
+                    return {};
+                }
+                m_pos += 2;
+            }
+            const auto inner = alternation();
+            if (!inner || atEnd() || peek() != ')') {
+                return {};
+            }
+            m_pos++;
+            return inner;
+        }
+        case '[':
+            return characterClass();
+        case '.': {
+            ByteSet set;
+            set.set();
+            set.reset('\n');
+            set.reset('\r');
+            return addSet(set);
+        }
+        case '^':
+            return add({ AstNode::Begin });
+        case '$':
+            return add({ AstNode::End });
+        case '\\': {
+            ByteSet set;
+            if (!escape(set, false)) {
+                return {};
+            }
+            return addSet(set);
+        }
+        case '*': case '+': case '?': case '{': case '}': case ')': case ']':
+            return {};
+        default: {
+            ByteSet set;
+            set.set(static_cast<unsigned char>(c));
+            return addSet(set);
+        }
+        }
+    }
+
+    std::optional<int> characterClass() {
+        ByteSet set;
+        bool negated = false;
+        if (!atEnd() && peek() == '^') {
+            negated = true;
+            m_pos++;
+        }
+        // `[]` and `[^]` mean something else in ECMAScript.
+        if (atEnd() || peek() == ']') {
+            return {};
+        }
+        while (!atEnd() && peek() != ']') {
+            if (m_pattern.compare(m_pos, 2, "[:") == 0 || m_pattern.compare(m_pos, 2, "[=") == 0
+                || m_pattern.compare(m_pos, 2, "[.") == 0) {
+                return {};
+            }
+            ByteSet item;
+            int low = -1;
+            if (!classItem(item, low)) {
+                return {};
+            }
+            if (low >= 0 && m_pos + 1 < m_pattern.size() && peek() == '-' && m_pattern[m_pos + 1] != ']') {
+                m_pos++;
+                ByteSet end;
+                int high = -1;
+                if (!classItem(end, high) || high < low) {
+                    return {};
+                }
+                for (int b = low; b <= high; b++) {
+                    set.set(b);
+                }
+            } else {
+                set |= item;
+            }
+        }
+        if (atEnd()) {
+            return {};
+        }
+        m_pos++;
+        if (negated) {
+            set.flip();
+        }
+        return addSet(set);
+    }
+
+    /** One character or escape; `single` is set if it is a single byte. */
+    bool classItem(ByteSet& set, int& single) {
+        const char c = peek();
+        m_pos++;
+        if (c == '\\') {
+            if (!escape(set, true)) {
+                return false;
+            }
+        } else {
+            set.set(static_cast<unsigned char>(c));
+        }
+        single = set.count() == 1 ? static_cast<int>(firstByte(set)) : -1;
+        return true;
+    }
+
+    static size_t firstByte(const ByteSet& set) {
+        for (size_t b=0; b<256; b++) {
+            if (set.test(b)) {
+                return b;
+            }
+        }
+        return 256;
+    }
+
+    bool escape(ByteSet& set, bool inClass) {
+        if (atEnd()) {
+            return false;
+        }
+        const char c = peek();
+        m_pos++;
+        switch (c) {
+        case 'd': case 'D':
+            for (int b = '0'; b <= '9'; b++) set.set(b);
+            break;
+        case 'w': case 'W':
+            for (int b = '0'; b <= '9'; b++) set.set(b);
+            for (int b = 'a'; b <= 'z'; b++) set.set(b);
+            for (int b = 'A'; b <= 'Z'; b++) set.set(b);
+            set.set('_');
+            break;
+        case 's': case 'S':
+            for (const char s : { ' ', '\t', '\n', '\r', '\f', '\v' }) set.set(static_cast<unsigned char>(s));
+            break;
+        case 'n': set.set('\n'); return true;
+        case 'r': set.set('\r'); return true;
+        case 't': set.set('\t'); return true;
+        case 'f': set.set('\f'); return true;
+        case 'v': set.set('\v'); return true;
+        case 'b':
+            // Backspace in a class, a word boundary outside.
+            if (!inClass) {
+                return false;
+            }
+            set.set('\b');
+            return true;
+        case 'x': {
+            if (m_pos + 2 > m_pattern.size()) {
+                return false;
+            }
+            int value = 0;
+            for (int i=0; i<2; i++) {
+                const char h = m_pattern[m_pos++];
+                value *= 16;
+                if (h >= '0' && h <= '9') value += h - '0';
+                else if (h >= 'a' && h <= 'f') value += h - 'a' + 10;
+                else if (h >= 'A' && h <= 'F') value += h - 'A' + 10;
+                else return false;
+            }
+            set.set(value);
+            return true;
+        }
+        default:
+            // Only punctuation escapes to itself; letters and digits are
+            // backreferences, word boundaries and other special cases.
+            if (std::isalnum(static_cast<unsigned char>(c))) {
+                return false;
+            }
+            set.set(static_cast<unsigned char>(c));
+            return true;
+        }
+        if (std::isupper(static_cast<unsigned char>(c))) {
+            set.flip();
+        }
+        return true;
+    }
+
+    const std::string& m_pattern;
+    size_t m_pos = 0;
+};
+
+struct NfaState {
+    enum Kind { Set, Split, Begin, End, Match };
+    Kind kind;
+    int out = -1;
+    int out1 = -1;
+    /** Index in Nfa.sets. */
+    int set = -1;
+};
+
+/** A Thompson NFA, built back to front from the syntax tree. */
+struct Nfa {
+    std::vector<NfaState> states;
+    std::vector<ByteSet> sets;
+    int start = -1;
+    bool tooLarge = false;
+
+    int add(NfaState state) {
+        if (states.size() >= MAX_NFA_STATES) {
+            tooLarge = true;
+        }
+        states.push_back(state);
+        return static_cast<int>(states.size() - 1);
+    }
+
+    int build(const std::vector<AstNode>& ast, int node, int next) {
+        if (tooLarge) {
+            return next;
+        }
+        const AstNode& n = ast[node];
+        switch (n.kind) {
+        case AstNode::Set: {
+            const auto it = std::find(sets.begin(), sets.end(), n.set);
+            const int set = static_cast<int>(it - sets.begin());
+            if (it == sets.end()) {
+                sets.push_back(n.set);
+            }
+            return add({ NfaState::Set, next, -1, set });
+        }
+        case AstNode::Concat:
+            for (auto it = n.children.rbegin(); it != n.children.rend(); ++it) {
+                next = build(ast, *it, next);
+            }
+            return next;
+        case AstNode::Alt: {
+            int result = build(ast, n.children.back(), next);
+            for (size_t i = n.children.size() - 1; i-- > 0;) {
+                const int branch = build(ast, n.children[i], next);
+                result = add({ NfaState::Split, branch, result });
+            }
+            return result;
+        }
+        case AstNode::Repeat: {
+            const int child = n.children[0];
+            int result = next;
+            if (n.max == UNBOUNDED) {
+                const int loop = add({ NfaState::Split, -1, next });
+                states[loop].out = build(ast, child, loop);
+                result = loop;
+            } else {
+                for (int i = n.min; i < n.max; i++) {
+                    const int body = build(ast, child, result);
+                    result = add({ NfaState::Split, body, next });
+                }
+            }
+            for (int i=0; i<n.min; i++) {
+                result = build(ast, child, result);
+            }
+            return result;
+        }
+        case AstNode::Begin:
+            return add({ NfaState::Begin, next });
+        case AstNode::End:
+            return add({ NfaState::End, next });
+        }
+        return next;
+    }
+
+    /**
+     * Add `state` and everything reachable from it without consuming a
+     * byte. Assertions are only crossed where they hold.
+     */
+    void closure(int state, bool atBegin, bool atEnd, std::vector<bool>& seen, std::vector<int>& result) const {
+        std::vector<int> stack = { state };
+        while (!stack.empty()) {
+            const int s = stack.back();
+            stack.pop_back();
+            if (s < 0 || seen[s]) {
+                continue;
+            }
+            seen[s] = true;
+            const NfaState& st = states[s];
+            switch (st.kind) {
+            case NfaState::Split:
+                stack.push_back(st.out1);
+                stack.push_back(st.out);
+                break;
+            case NfaState::Begin:
+                result.push_back(s);
+                if (atBegin) {
+                    stack.push_back(st.out);
+                }
+                break;
+            case NfaState::End:
+                result.push_back(s);
+                if (atEnd) {
+                    stack.push_back(st.out);
+                }
+                break;
+            default:
+                result.push_back(s);
+                break;
+            }
+        }
+    }
+};
+
+/** The longest run of single bytes that every match contains. */
+std::string requiredLiteral(const std::vector<AstNode>& ast, int root, bool& whole) {
+    std::vector<int> items;
+    if (ast[root].kind == AstNode::Concat) {
+        items = ast[root].children;
+    } else {
+        items = { root };
+    }
+    // Flatten nested groups.
+    for (size_t i=0; i<items.size();) {
+        if (ast[items[i]].kind == AstNode::Concat) {
+            const std::vector<int> inner = ast[items[i]].children;
+            items.erase(items.begin() + i);
+            items.insert(items.begin() + i, inner.begin(), inner.end());
+        } else {
+            i++;
+        }
+    }
+
+    std::string best;
+    std::string run;
+    whole = true;
+    for (const int item : items) {
+        const AstNode& node = ast[item];
+        if (node.kind == AstNode::Set && node.set.count() == 1) {
+            for (size_t b=0; b<256; b++) {
+                if (node.set.test(b)) {
+                    run.push_back(static_cast<char>(b));
+                    break;
+                }
+            }
+            continue;
+        }
+        whole = false;
+        if (run.size() > best.size()) {
+            best = run;
+        }
+        run.clear();
+    }
+    if (run.size() > best.size()) {
+        best = run;
+    }
+    return best;
+}
+
+}
+
+Regex::Regex(const std::string& pattern) {
+    if (!compile(pattern)) {
+        m_states.clear();
+        m_transitions.clear();
+        m_required.clear();
+        m_literal = false;
+        m_fallback = std::make_unique<std::regex>(pattern, std::regex::ECMAScript);
+    }
+}
+
+bool Regex::compile(const std::string& pattern) {
+    Parser parser(pattern);
+    const auto root = parser.parse();
+    if (!root) {
+        return false;
+    }
+    const std::vector<AstNode>& ast = parser.nodes;
+
+    m_required = requiredLiteral(ast, *root, m_literal);
+    if (m_literal) {
+        return true;
+    }
+
+    Nfa nfa;
+    const int match = nfa.add({ NfaState::Match });
+    nfa.start = nfa.build(ast, *root, match);
+    if (nfa.tooLarge) {
+        return false;
+    }
+
+    // Bytes no set tells apart share a class.
+    m_classCount = 1;
+    for (const ByteSet& set : nfa.sets) {
+        std::map<std::pair<uint8_t, bool>, uint8_t> split;
+        uint8_t classes[256];
+        for (int b=0; b<256; b++) {
+            const auto key = std::make_pair(m_classes[b], set.test(b));
+            const auto it = split.emplace(key, static_cast<uint8_t>(split.size())).first;
+            classes[b] = it->second;
+        }
+        std::copy(classes, classes + 256, m_classes);
+        m_classCount = static_cast<uint32_t>(split.size());
+    }
+    std::vector<uint8_t> representative(m_classCount);
+    for (int b=255; b>=0; b--) {
+        representative[m_classes[b]] = static_cast<uint8_t>(b);
+    }
+
+    // Subset construction. Every state also restarts the search at the
+    // next position, where `^` no longer holds.
+    // The initial state is kept apart, as `^` still holds at its end.
+    std::map<std::pair<bool, std::vector<int>>, uint32_t> ids;
+    std::vector<std::vector<int>> sets;
+    const auto intern = [&](std::vector<int> states, bool initial) -> uint32_t {
+        std::sort(states.begin(), states.end());
+        auto key = std::make_pair(initial, std::move(states));
+        const auto it = ids.find(key);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        const uint32_t id = static_cast<uint32_t>(sets.size());
+        sets.push_back(key.second);
+        ids.emplace(std::move(key), id);
+        return id;
+    };
+
+    std::vector<bool> seen(nfa.states.size());
+    std::vector<int> initial;
+    nfa.closure(nfa.start, true, false, seen, initial);
+    intern(initial, true);
+
+    std::vector<bool> restartSeen(nfa.states.size());
+    std::vector<int> restart;
+    nfa.closure(nfa.start, false, false, restartSeen, restart);
+
+    for (uint32_t id = 0; id < sets.size(); id++) {
+        if (sets.size() > MAX_DFA_STATES) {
+            return false;
+        }
+        const std::vector<int> current = sets[id];
+
+        State state = { false, false, true };
+        for (const int s : current) {
+            const NfaState::Kind kind = nfa.states[s].kind;
+            if (kind == NfaState::Match) {
+                state.accepting = true;
+            }
+            if (kind == NfaState::Set || kind == NfaState::Match || kind == NfaState::End) {
+                state.dead = false;
+            }
+        }
+        std::vector<bool> endSeen(nfa.states.size());
+        std::vector<int> atEnd;
+        for (const int s : current) {
+            nfa.closure(s, id == 0, true, endSeen, atEnd);
+        }
+        state.acceptingAtEnd = std::find(atEnd.begin(), atEnd.end(), match) != atEnd.end();
+        m_states.push_back(state);
+
+        for (uint32_t c = 0; c < m_classCount; c++) {
+            std::fill(seen.begin(), seen.end(), false);
+            std::vector<int> next;
+            for (const int s : current) {
+                const NfaState& st = nfa.states[s];
+                if (st.kind == NfaState::Set && nfa.sets[st.set].test(representative[c])) {
+                    nfa.closure(st.out, false, false, seen, next);
+                }
+            }
+            nfa.closure(nfa.start, false, false, seen, next);
+            m_transitions.push_back(intern(std::move(next), false));
+        }
+    }
+    return true;
+}
+
+bool Regex::search(std::string_view text) const {
+    if (m_fallback) {
+        return std::regex_search(text.begin(), text.end(), *m_fallback);
+    }
+    if (!m_required.empty() && text.find(m_required) == std::string_view::npos) {
+        return false;
+    }
+    if (m_literal) {
+        return true;
+    }
+
+    uint32_t state = 0;
+    for (const char c : text) {
+        const State& s = m_states[state];
+        if (s.accepting) {
+            return true;
+        }
+        if (s.dead) {
+            return false;
+        }
+        state = m_transitions[state * m_classCount + m_classes[static_cast<unsigned char>(c)]];
+    }
+    return m_states[state].accepting || m_states[state].acceptingAtEnd;
+}
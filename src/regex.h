@@ -0,0 +1,60 @@
+/**
+ * @file regex.h
+ * @brief Regular expressions for query predicates.
+ *
+ * Patterns are compiled once, into a DFA over byte classes, and searched
+ * without backtracking or allocation. A literal every match must contain
+ * is looked for first, so most non-matching texts are rejected by a
+ * plain substring search. Syntax the DFA cannot express (backreferences,
+ * lookaround, word boundaries, ...) falls back to std::regex.
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace TreeSitter {
+namespace Internal {
+
+class Regex {
+public:
+    /**
+     * @brief Compile an ECMAScript pattern.
+     *
+     * @throws std::regex_error If the pattern is invalid.
+     */
+    explicit Regex(const std::string& pattern);
+
+    /** Returns `true` if the pattern matches somewhere in `text`. */
+    bool search(std::string_view text) const;
+
+    /** Returns `true` if the pattern is matched by the DFA. */
+    bool compiled() const { return !m_fallback; }
+private:
+    struct State {
+        bool accepting;
+        bool acceptingAtEnd;
+        bool dead;
+    };
+
+    bool compile(const std::string& pattern);
+
+    /** Byte class of every byte. */
+    uint8_t m_classes[256] = {};
+    uint32_t m_classCount = 0;
+    std::vector<State> m_states;
+    /** Transition table, `m_classCount` entries per state. */
+    std::vector<uint32_t> m_transitions;
+    /** A literal every match contains. */
+    std::string m_required;
+    /** The whole pattern is `m_required`. */
+    bool m_literal = false;
+    std::unique_ptr<std::regex> m_fallback;
+};
+
+}
+}
@@ -0,0 +1,440 @@
+#include <charconv>
+#include <string_view>
+#include <vector>
+#include "tree_sitter/api.h"
+#include "tree_sitter/cxx/node.h"
+#include "tree_sitter/cxx/serializer.h"
+#include "tree_sitter/cxx/tree.h"
+
+using namespace TreeSitter;
+
+static constexpr size_t BUFFER_SIZE = 16 * 1024;
+
+namespace {
+
+struct Frame {
+    bool bare;
+    bool hasChildren;
+};
+
+}
+
+struct Serializer::Private {
+    Options options = { SExpression, false, false, true, false };
+    Sink sink;
+    std::string_view source;
+    std::vector<char> buffer = {};
+    std::vector<Frame> open = {};
+    std::vector<bool> emitted = {};
+
+    void flush();
+    void append(const char* data, size_t length);
+    void append(std::string_view str);
+    void append(uint32_t number);
+    void appendEscaped(std::string_view str);
+
+    void openNode(TSNode node, const char* field);
+    void closeNode(TSNode node);
+    void beforeChild(Frame& parent);
+    void writePositions(TSNode node);
+    void writeText(TSNode node);
+    void run(TSNode root);
+};
+
+void Serializer::Private::flush() {
+    if (!buffer.empty()) {
+        sink(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+}
+
+void Serializer::Private::append(const char* data, size_t length) {
+    if (buffer.size() + length > BUFFER_SIZE) {
+        flush();
+        if (length >= BUFFER_SIZE) {
+            sink(data, length);
+            return;
+        }
+    }
+    buffer.insert(buffer.end(), data, data + length);
+}
+
+void Serializer::Private::append(std::string_view str) {
+    append(str.data(), str.size());
+}
+
+void Serializer::Private::append(uint32_t number) {
+    char digits[16];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    append(digits, result.ptr - digits);
+}
+
+void Serializer::Private::appendEscaped(std::string_view str) {
+    static const char hex[] = "0123456789abcdef";
+    size_t start = 0;
+    for (size_t i=0; i<str.size(); i++) {
+        const unsigned char c = str[i];
+        const char* replacement = nullptr;
+        char unicode[7] = { '\\', 'u', '0', '0', 0, 0, 0 };
+
+        if (options.format == XML) {
+            switch (c) {
+            case '&': replacement = "&amp;"; break;
+            case '<': replacement = "&lt;"; break;
+            case '>': replacement = "&gt;"; break;
+            case '"': replacement = "&quot;"; break;
+            case '\'': replacement = "&apos;"; break;
+            case '\t': case '\n': case '\r': break;
+            default:
+                // XML 1.0 forbids other control characters, even as references.
+                if (c < 0x20) {
+                    replacement = "\xef\xbf\xbd";
+                }
+                break;
+            }
+        } else {
+            switch (c) {
+            case '"': replacement = "\\\""; break;
+            case '\\': replacement = "\\\\"; break;
+            case '\n': replacement = "\\n"; break;
+            case '\r': replacement = "\\r"; break;
+            case '\t': replacement = "\\t"; break;
+            default:
+                if (c < 0x20 && options.format == JSON) {
+                    unicode[4] = hex[c >> 4];
+                    unicode[5] = hex[c & 0xf];
+                    replacement = unicode;
+                }
+                break;
+            }
+        }
+
+        if (replacement != nullptr) {
+            append(str.data() + start, i - start);
+            append(std::string_view(replacement));
+            start = i + 1;
+        }
+    }
+    append(str.data() + start, str.size() - start);
+}
+
+void Serializer::Private::writePositions(TSNode node) {
+    const TSPoint start = ts_node_start_point(node);
+    const TSPoint end = ts_node_end_point(node);
+
+    switch (options.format) {
+    case SExpression:
+        append(" [");
+        append(start.row);
+        append(", ");
+        append(start.column);
+        append("] - [");
+        append(end.row);
+        append(", ");
+        append(end.column);
+        append("]");
+        break;
+    case JSON:
+        append(",\"startIndex\":");
+        append(ts_node_start_byte(node));
+        append(",\"endIndex\":");
+        append(ts_node_end_byte(node));
+        append(",\"startPosition\":{\"row\":");
+        append(start.row);
+        append(",\"column\":");
+        append(start.column);
+        append("},\"endPosition\":{\"row\":");
+        append(end.row);
+        append(",\"column\":");
+        append(end.column);
+        append("}");
+        break;
+    case XML:
+        append(" startIndex=\"");
+        append(ts_node_start_byte(node));
+        append("\" endIndex=\"");
+        append(ts_node_end_byte(node));
+        append("\" startRow=\"");
+        append(start.row);
+        append("\" startColumn=\"");
+        append(start.column);
+        append("\" endRow=\"");
+        append(end.row);
+        append("\" endColumn=\"");
+        append(end.column);
+        append("\"");
+        break;
+    }
+}
+
+void Serializer::Private::writeText(TSNode node) {
+    const uint32_t start = ts_node_start_byte(node);
+    const uint32_t end = ts_node_end_byte(node);
+    if (start > end || end > source.size()) {
+        return;
+    }
+    const std::string_view text = source.substr(start, end - start);
+
+    switch (options.format) {
+    case SExpression:
+        append(" \"");
+        appendEscaped(text);
+        append("\"");
+        break;
+    case JSON:
+        append(",\"text\":\"");
+        appendEscaped(text);
+        append("\"");
+        break;
+    case XML:
+        appendEscaped(text);
+        break;
+    }
+}
+
+void Serializer::Private::beforeChild(Frame& parent) {
+    switch (options.format) {
+    case SExpression:
+        append(" ");
+        break;
+    case JSON:
+        append(parent.hasChildren ? "," : ",\"children\":[");
+        break;
+    case XML:
+        if (!parent.hasChildren) {
+            append(">");
+        }
+        break;
+    }
+    parent.hasChildren = true;
+}
+
+void Serializer::Private::openNode(TSNode node, const char* field) {
+    const bool named = ts_node_is_named(node);
+    const bool missing = ts_node_is_missing(node);
+    const std::string_view type = ts_node_type(node);
+    const bool leaf = ts_node_child_count(node) == 0;
+    const bool hasField = field != nullptr && options.includeFieldNames;
+    Frame frame = { false, false };
+
+    switch (options.format) {
+    case SExpression:
+        if (hasField) {
+            append(field);
+            append(": ");
+        }
+        if (!named && !missing) {
+            append("\"");
+            appendEscaped(type);
+            append("\"");
+            frame.bare = true;
+            break;
+        }
+        append(missing ? "(MISSING " : "(");
+        if (named) {
+            append(type);
+        } else {
+            append("\"");
+            appendEscaped(type);
+            append("\"");
+        }
+        if (options.includePositions) {
+            writePositions(node);
+        }
+        if (options.includeText && leaf) {
+            writeText(node);
+        }
+        break;
+    case JSON:
+        append("{\"type\":\"");
+        appendEscaped(type);
+        append(named ? "\",\"named\":true" : "\",\"named\":false");
+        if (missing) {
+            append(",\"missing\":true");
+        }
+        if (hasField) {
+            append(",\"field\":\"");
+            append(field);
+            append("\"");
+        }
+        if (options.includePositions) {
+            writePositions(node);
+        }
+        if (options.includeText && leaf) {
+            writeText(node);
+        }
+        break;
+    case XML:
+        if (named) {
+            append("<");
+            append(type);
+        } else {
+            append("<anonymous type=\"");
+            appendEscaped(type);
+            append("\"");
+        }
+        if (hasField) {
+            append(" field=\"");
+            append(field);
+            append("\"");
+        }
+        if (missing) {
+            append(" missing=\"true\"");
+        }
+        if (options.includePositions) {
+            writePositions(node);
+        }
+        if (options.includeText && leaf) {
+            append(">");
+            writeText(node);
+            frame.hasChildren = true;
+        }
+        break;
+    }
+
+    open.push_back(frame);
+}
+
+void Serializer::Private::closeNode(TSNode node) {
+    const Frame frame = open.back();
+    open.pop_back();
+
+    switch (options.format) {
+    case SExpression:
+        if (!frame.bare) {
+            append(")");
+        }
+        break;
+    case JSON:
+        append(frame.hasChildren ? "]}" : "}");
+        break;
+    case XML:
+        if (!frame.hasChildren) {
+            append("/>");
+        } else if (ts_node_is_named(node)) {
+            append("</");
+            append(ts_node_type(node));
+            append(">");
+        } else {
+            append("</anonymous>");
+        }
+        break;
+    }
+}
+
+void Serializer::Private::run(TSNode root) {
+    open.clear();
+    emitted.clear();
+    buffer.reserve(BUFFER_SIZE);
+
+    if (options.format == XML) {
+        append("<?xml version=\"1.0\"?>\n");
+    }
+
+    TSTreeCursor cursor = ts_tree_cursor_new(root);
+    uint32_t depth = 0;
+
+    const auto enter = [this, &cursor]() {
+        const TSNode node = ts_tree_cursor_current_node(&cursor);
+        const bool emit = options.includeAnonymous
+            || ts_node_is_named(node)
+            || ts_node_is_missing(node);
+        if (emit) {
+            if (!open.empty()) {
+                beforeChild(open.back());
+            }
+            openNode(node, ts_tree_cursor_current_field_name(&cursor));
+        }
+        emitted.push_back(emit);
+    };
+
+    const auto leave = [this, &cursor]() {
+        if (emitted.back()) {
+            closeNode(ts_tree_cursor_current_node(&cursor));
+        }
+        emitted.pop_back();
+    };
+
+    enter();
+    bool done = false;
+    while (!done) {
+        if (ts_tree_cursor_goto_first_child(&cursor)) {
+            depth++;
+            enter();
+            continue;
+        }
+        while (true) {
+            leave();
+            if (depth == 0) {
+                done = true;
+                break;
+            }
+            if (ts_tree_cursor_goto_next_sibling(&cursor)) {
+                enter();
+                break;
+            }
+            ts_tree_cursor_goto_parent(&cursor);
+            depth--;
+        }
+    }
+    ts_tree_cursor_delete(&cursor);
+
+    if (options.format == XML) {
+        append("\n");
+    }
+    flush();
+}
+
+Serializer::Serializer(Format format)
+    : d(std::make_unique<Private>())
+{
+    d->options.format = format;
+}
+
+Serializer::Serializer(Options options)
+    : d(std::make_unique<Private>())
+{
+    d->options = options;
+}
+
+Serializer::Serializer(const Serializer& serializer)
+    : d(std::make_unique<Private>())
+{
+    d->options = serializer.d->options;
+}
+
+Serializer& Serializer::operator=(const Serializer &serializer) {
+    d->options = serializer.d->options;
+    return *this;
+}
+
+Serializer::~Serializer() = default;
+
+Serializer::Options Serializer::options() const {
+    return d->options;
+}
+
+void Serializer::setOptions(Options options) {
+    d->options = options;
+}
+
+void Serializer::write(const Node& node, Sink sink) {
+    d->sink = sink;
+    d->source = node.tree()->source();
+    d->run(node.node());
+    d->sink = nullptr;
+}
+
+void Serializer::write(const Node& node, std::ostream& out) {
+    write(node, [&out](const char* data, size_t length) {
+        out.write(data, length);
+    });
+}
+
+std::string Serializer::toString(const Node& node) {
+    std::string result;
+    write(node, [&result](const char* data, size_t length) {
+        result.append(data, length);
+    });
+    return result;
+}
@@ -0,0 +1,336 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include "tree_sitter/cxx/symbolindex.h"
+
+using namespace TreeSitter;
+
+namespace {
+
+constexpr char MAGIC[8] = { 'T', 'S', 'S', 'Y', 'M', 'I', 'D', 'X' };
+constexpr uint32_t VERSION = 1;
+
+/** Writes little-endian integers and length-prefixed strings. */
+class Writer {
+public:
+    explicit Writer(std::ostream& out) : m_out(out) { }
+
+    void u8(uint8_t value) {
+        m_out.put(static_cast<char>(value));
+    }
+
+    void u32(uint32_t value) {
+        char bytes[4];
+        for (int i=0; i<4; i++) {
+            bytes[i] = static_cast<char>(value >> (8 * i));
+        }
+        m_out.write(bytes, sizeof(bytes));
+    }
+
+    void u64(uint64_t value) {
+        u32(static_cast<uint32_t>(value));
+        u32(static_cast<uint32_t>(value >> 32));
+    }
+
+    void string(std::string_view value) {
+        u32(static_cast<uint32_t>(value.size()));
+        m_out.write(value.data(), value.size());
+    }
+
+    void range(const Range& range) {
+        u32(range.start_point.row);
+        u32(range.start_point.column);
+        u32(range.end_point.row);
+        u32(range.end_point.column);
+        u32(range.start_byte);
+        u32(range.end_byte);
+    }
+private:
+    std::ostream& m_out;
+};
+
+/** Reads what Writer writes; throws on truncated data. */
+class Reader {
+public:
+    explicit Reader(std::istream& in) : m_in(in) { }
+
+    void bytes(char* data, size_t length) {
+        if (!m_in.read(data, length)) {
+            fail();
+        }
+    }
+
+    uint8_t u8() {
+        char byte;
+        bytes(&byte, 1);
+        return static_cast<uint8_t>(byte);
+    }
+
+    uint32_t u32() {
+        unsigned char data[4];
+        bytes(reinterpret_cast<char*>(data), sizeof(data));
+        uint32_t value = 0;
+        for (int i=0; i<4; i++) {
+            value |= uint32_t(data[i]) << (8 * i);
+        }
+        return value;
+    }
+
+    uint64_t u64() {
+        const uint64_t low = u32();
+        return low | uint64_t(u32()) << 32;
+    }
+
+    std::string string() {
+        // Grow as data arrives, so a corrupted length cannot allocate much.
+        constexpr size_t CHUNK = 64 * 1024;
+        const size_t length = u32();
+        std::string value;
+        while (value.size() < length) {
+            const size_t offset = value.size();
+            value.resize(offset + std::min(CHUNK, length - offset));
+            bytes(&value[offset], value.size() - offset);
+        }
+        return value;
+    }
+
+    Range range() {
+        Range range;
+        range.start_point.row = u32();
+        range.start_point.column = u32();
+        range.end_point.row = u32();
+        range.end_point.column = u32();
+        range.start_byte = u32();
+        range.end_byte = u32();
+        return range;
+    }
+
+    [[noreturn]] static void fail() {
+        throw std::runtime_error("Invalid symbol index");
+    }
+private:
+    std::istream& m_in;
+};
+
+}
+
+struct SymbolIndex::Private {
+    /** A tag in `names`; points into `files`, whose nodes and tags do not move. */
+    struct Entry {
+        const std::string* path;
+        const Tagger::Tag* tag;
+    };
+
+    /** Keys are views of the tag names. */
+    using Names = std::multimap<std::string_view, Entry>;
+
+    struct File {
+        uint64_t stamp;
+        std::vector<Tagger::Tag> tags;
+        /** The entries of the tags in `names`, to remove them directly. */
+        std::vector<Names::iterator> entries = {};
+    };
+
+    std::map<std::string, File> files;
+    Names names;
+    size_t size = 0;
+
+    Private() = default;
+    Private(const Private& other) : files(other.files) { reindex(); }
+    Private& operator=(const Private& other) {
+        files = other.files;
+        reindex();
+        return *this;
+    }
+
+    void add(std::map<std::string, File>::iterator file);
+    void reindex();
+    Symbol symbol(const Entry& entry) const;
+};
+
+void SymbolIndex::Private::add(std::map<std::string, File>::iterator file) {
+    File& data = file->second;
+    data.entries.clear();
+    data.entries.reserve(data.tags.size());
+    for (const Tagger::Tag& tag : data.tags) {
+        data.entries.push_back(names.emplace(tag.name, Entry { &file->first, &tag }));
+    }
+    size += data.tags.size();
+}
+
+void SymbolIndex::Private::reindex() {
+    names.clear();
+    size = 0;
+    for (auto file = files.begin(); file != files.end(); ++file) {
+        add(file);
+    }
+}
+
+SymbolIndex::Symbol SymbolIndex::Private::symbol(const Entry& entry) const {
+    return { *entry.path, *entry.tag };
+}
+
+SymbolIndex::SymbolIndex()
+    : d(std::make_unique<Private>()) { }
+
+SymbolIndex::SymbolIndex(const SymbolIndex& index)
+    : d(std::make_unique<Private>(*index.d)) { }
+
+SymbolIndex& SymbolIndex::operator=(const SymbolIndex &index) {
+    *d = *index.d;
+    return *this;
+}
+
+SymbolIndex::~SymbolIndex() = default;
+
+SymbolIndex SymbolIndex::load(std::istream& in) {
+    Reader reader(in);
+    char magic[sizeof(MAGIC)];
+    reader.bytes(magic, sizeof(magic));
+    if (!std::equal(magic, magic + sizeof(magic), MAGIC) || reader.u32() != VERSION) {
+        Reader::fail();
+    }
+
+    SymbolIndex index;
+    const uint64_t fileCount = reader.u64();
+    for (uint64_t i=0; i<fileCount; i++) {
+        std::string path = reader.string();
+        Private::File file = { reader.u64(), {} };
+        const uint32_t tagCount = reader.u32();
+        for (uint32_t j=0; j<tagCount; j++) {
+            Tagger::Tag tag;
+            tag.name = reader.string();
+            tag.kind = reader.string();
+            tag.definition = reader.u8() != 0;
+            tag.range = reader.range();
+            tag.nameRange = reader.range();
+            tag.docs = reader.string();
+            file.tags.push_back(std::move(tag));
+        }
+        if (!index.d->files.emplace(std::move(path), std::move(file)).second) {
+            Reader::fail();
+        }
+    }
+    index.d->reindex();
+    return index;
+}
+
+SymbolIndex SymbolIndex::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return SymbolIndex();
+    }
+    return load(in);
+}
+
+void SymbolIndex::save(std::ostream& out) const {
+    Writer writer(out);
+    out.write(MAGIC, sizeof(MAGIC));
+    writer.u32(VERSION);
+    writer.u64(d->files.size());
+    for (const auto& [path, file] : d->files) {
+        writer.string(path);
+        writer.u64(file.stamp);
+        writer.u32(static_cast<uint32_t>(file.tags.size()));
+        for (const Tagger::Tag& tag : file.tags) {
+            writer.string(tag.name);
+            writer.string(tag.kind);
+            writer.u8(tag.definition ? 1 : 0);
+            writer.range(tag.range);
+            writer.range(tag.nameRange);
+            writer.string(tag.docs);
+        }
+    }
+}
+
+void SymbolIndex::save(const std::string& path) const {
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        save(out);
+        out.close();
+        if (!out) {
+            std::remove(temporary.c_str());
+            throw std::runtime_error("Cannot write file " + path);
+        }
+    }
+    // Windows does not replace existing files when renaming.
+    if (std::rename(temporary.c_str(), path.c_str()) != 0
+        && (std::remove(path.c_str()) != 0 || std::rename(temporary.c_str(), path.c_str()) != 0))
+    {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Cannot write file " + path);
+    }
+}
+
+size_t SymbolIndex::fileCount() const {
+    return d->files.size();
+}
+
+size_t SymbolIndex::size() const {
+    return d->size;
+}
+
+std::vector<std::string> SymbolIndex::files() const {
+    std::vector<std::string> result;
+    result.reserve(d->files.size());
+    for (const auto& file : d->files) {
+        result.push_back(file.first);
+    }
+    return result;
+}
+
+std::optional<uint64_t> SymbolIndex::stamp(const std::string& path) const {
+    const auto file = d->files.find(path);
+    if (file == d->files.end()) {
+        return std::nullopt;
+    }
+    return file->second.stamp;
+}
+
+void SymbolIndex::update(const std::string& path, uint64_t stamp, std::vector<Tagger::Tag> tags) {
+    remove(path);
+    const auto file = d->files.emplace(path, Private::File { stamp, std::move(tags) }).first;
+    d->add(file);
+}
+
+bool SymbolIndex::remove(const std::string& path) {
+    const auto file = d->files.find(path);
+    if (file == d->files.end()) {
+        return false;
+    }
+    for (const auto entry : file->second.entries) {
+        d->names.erase(entry);
+    }
+    d->size -= file->second.tags.size();
+    d->files.erase(file);
+    return true;
+}
+
+void SymbolIndex::clear() {
+    d->names.clear();
+    d->files.clear();
+    d->size = 0;
+}
+
+std::vector<SymbolIndex::Symbol> SymbolIndex::find(std::string_view name) const {
+    std::vector<Symbol> result;
+    const auto [begin, end] = d->names.equal_range(name);
+    for (auto entry = begin; entry != end; ++entry) {
+        result.push_back(d->symbol(entry->second));
+    }
+    return result;
+}
+
+std::vector<SymbolIndex::Symbol> SymbolIndex::findPrefix(std::string_view prefix, size_t limit) const {
+    std::vector<Symbol> result;
+    for (auto entry = d->names.lower_bound(prefix); entry != d->names.end(); ++entry) {
+        if (entry->first.compare(0, prefix.size(), prefix) != 0 || (limit > 0 && result.size() == limit)) {
+            break;
+        }
+        result.push_back(d->symbol(entry->second));
+    }
+    return result;
+}
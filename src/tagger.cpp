@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <optional>
+#include <regex>
+#include <stdexcept>
+#include <unordered_map>
+#include "tree_sitter/cxx/node.h"
+#include "tree_sitter/cxx/tagger.h"
+#include "tree_sitter/cxx/tree.h"
+
+using namespace TreeSitter;
+
+namespace {
+
+constexpr uint32_t NO_ROLE = UINT32_MAX;
+
+/** What a capture is for. */
+struct Role {
+    /** `true` for `@definition.*`, `false` for `@reference.*`. */
+    bool definition;
+    std::string kind;
+};
+
+Range nodeRange(const Node& node) {
+    const TSNode raw = node.node();
+    return {
+        ts_node_start_point(raw),
+        ts_node_end_point(raw),
+        ts_node_start_byte(raw),
+        ts_node_end_byte(raw),
+    };
+}
+
+}
+
+struct Tagger::Private {
+    /** The predicates of one pattern. */
+    struct Pattern {
+        std::optional<std::regex> strip = std::nullopt;
+        bool selectAdjacent = false;
+    };
+
+    Query query;
+    /** Role of every capture, NO_ROLE if it is not a definition or reference. */
+    std::vector<uint32_t> captureRoles = {};
+    std::vector<Role> roles = {};
+    std::optional<uint32_t> nameCapture = std::nullopt;
+    std::optional<uint32_t> docCapture = std::nullopt;
+    std::optional<uint32_t> ignoreCapture = std::nullopt;
+    std::vector<Pattern> patterns = {};
+
+    std::string docs(const Pattern& pattern, const std::vector<Node>& nodes, const Node& tagged) const;
+};
+
+std::string Tagger::Private::docs(const Pattern& pattern, const std::vector<Node>& nodes, const Node& tagged) const {
+    // Comments are captured in order; walk them up from the definition.
+    std::vector<std::string> lines;
+    uint32_t row = tagged.startPosition().row;
+    for (auto node = nodes.rbegin(); node != nodes.rend(); ++node) {
+        if (pattern.selectAdjacent && node->endPosition().row + 1 < row) {
+            break;
+        }
+        row = node->startPosition().row;
+        std::string text = node->text();
+        if (pattern.strip) {
+            text = std::regex_replace(text, *pattern.strip, "");
+        }
+        lines.push_back(std::move(text));
+    }
+
+    std::string result;
+    for (auto line = lines.rbegin(); line != lines.rend(); ++line) {
+        if (!result.empty()) {
+            result += '\n';
+        }
+        result += *line;
+    }
+    return result;
+}
+
+Tagger::Tagger(const Query& query)
+    : d(std::make_unique<Private>(Private { query }))
+{
+    for (uint32_t i=0; i<query.captureCount(); i++) {
+        const std::string_view name = query.captureName(i);
+        uint32_t role = NO_ROLE;
+        for (const bool definition : { true, false }) {
+            const std::string_view prefix = definition ? "definition." : "reference.";
+            if (name.size() > prefix.size() && name.compare(0, prefix.size(), prefix) == 0) {
+                role = static_cast<uint32_t>(d->roles.size());
+                d->roles.push_back({ definition, std::string(name.substr(prefix.size())) });
+            }
+        }
+        d->captureRoles.push_back(role);
+    }
+    d->nameCapture = query.captureIndex("name");
+    d->docCapture = query.captureIndex("doc");
+    d->ignoreCapture = query.captureIndex("ignore");
+
+    for (uint32_t i=0; i<query.patternCount(); i++) {
+        Private::Pattern pattern;
+        for (const Query::PredicateResult& predicate : query.predicatesForPattern(i)) {
+            const auto& operands = predicate.operands;
+            if (predicate.operatorName == "strip!") {
+                if (operands.size() != 2 || operands[0].type != "capture" || operands[1].type != "string") {
+                    throw std::range_error("Arguments to `#strip!` must be a capture and a regex");
+                }
+                pattern.strip.emplace(operands[1].name);
+            } else if (predicate.operatorName == "select-adjacent!") {
+                pattern.selectAdjacent = true;
+            }
+        }
+        d->patterns.push_back(std::move(pattern));
+    }
+}
+
+Tagger::Tagger(const Tagger& tagger)
+    : d(std::make_unique<Private>(*tagger.d)) { }
+
+Tagger& Tagger::operator=(const Tagger &tagger) {
+    *d = *tagger.d;
+    return *this;
+}
+
+Tagger::~Tagger() = default;
+
+const Query& Tagger::query() const {
+    return d->query;
+}
+
+std::vector<Tagger::Tag> Tagger::tags(const Tree& tree) const {
+    std::vector<Tag> result;
+    if (!d->nameCapture) {
+        return result;
+    }
+
+    // Start and end of every tagged name, with its tag and number of comments.
+    std::unordered_map<uint64_t, std::pair<size_t, size_t>> names;
+    std::vector<Node> docs;
+    QueryCursor cursor;
+    for (const Query::Match& match : cursor.eachMatch(d->query, tree.rootNode())) {
+        const Query::Capture* name = nullptr;
+        const Query::Capture* tagged = nullptr;
+        bool ignored = false;
+        docs.clear();
+        for (const Query::Capture& capture : match.captures) {
+            if (capture.index == d->nameCapture) {
+                name = &capture;
+            } else if (capture.index == d->docCapture) {
+                docs.push_back(capture.node);
+            } else if (capture.index == d->ignoreCapture) {
+                ignored = true;
+            } else if (!tagged && d->captureRoles[capture.index] != NO_ROLE) {
+                tagged = &capture;
+            }
+        }
+        if (ignored || !name || !tagged) {
+            continue;
+        }
+
+        const Range nameRange = nodeRange(name->node);
+        const auto [tag, added] = names.try_emplace(uint64_t(nameRange.start_byte) << 32 | nameRange.end_byte,
+            result.size(), docs.size());
+        if (!added) {
+            // `(comment)* @doc` also matches with fewer comments; keep them all.
+            auto& [index, docCount] = tag->second;
+            if (docs.size() > docCount) {
+                result[index].docs = d->docs(d->patterns[match.pattern], docs, tagged->node);
+                docCount = docs.size();
+            }
+            continue;
+        }
+        const Role& role = d->roles[d->captureRoles[tagged->index]];
+        result.push_back({
+            name->node.text(),
+            role.kind,
+            role.definition,
+            nodeRange(tagged->node),
+            nameRange,
+            docs.empty() ? std::string() : d->docs(d->patterns[match.pattern], docs, tagged->node),
+        });
+    }
+
+    std::stable_sort(result.begin(), result.end(), [](const Tag& a, const Tag& b) {
+        return a.nameRange.start_byte < b.nameRange.start_byte;
+    });
+    return result;
+}
@@ -0,0 +1,171 @@
+#include "tree_sitter/api.h"
+#include "tree_sitter/cxx/node.h"
+#include "tree_sitter/cxx/traversal.h"
+#include "cursor_pool.h"
+
+using namespace TreeSitter;
+
+Traversal::Traversal(const Tree* tree, TSNode root, Order order, bool namedOnly)
+    : m_tree(tree), m_root(root), m_order(order), m_namedOnly(namedOnly) { }
+
+Traversal::Traversal(Traversal&& traversal) noexcept
+    : m_tree(traversal.m_tree),
+      m_root(traversal.m_root),
+      m_order(traversal.m_order),
+      m_namedOnly(traversal.m_namedOnly),
+      m_cursor(traversal.m_cursor),
+      m_hasCursor(traversal.m_hasCursor),
+      m_started(traversal.m_started),
+      m_done(traversal.m_done),
+      m_skip(traversal.m_skip),
+      m_depth(traversal.m_depth),
+      m_queue(std::move(traversal.m_queue))
+{
+    traversal.m_hasCursor = false;
+    traversal.m_done = true;
+}
+
+Traversal::~Traversal() {
+    if (m_hasCursor) {
+        Internal::releaseCursor(m_cursor);
+    }
+}
+
+Traversal::iterator Traversal::begin() {
+    start();
+    return iterator(this);
+}
+
+void Traversal::start() {
+    if (m_hasCursor) {
+        ts_tree_cursor_reset(&m_cursor, m_root);
+    } else {
+        m_cursor = Internal::acquireCursor(m_root);
+        m_hasCursor = true;
+    }
+
+    m_started = true;
+    m_done = ts_node_is_null(m_root);
+    m_skip = false;
+    m_depth = 0;
+    m_queue.clear();
+
+    if (m_done) {
+        return;
+    }
+    if (m_order == PostOrder) {
+        descendLeftmost();
+    } else if (m_order == LevelOrder) {
+        m_queue.push_back({ m_root, 0, 0 });
+    }
+    if (m_namedOnly && !ts_node_is_named(current())) {
+        next();
+    }
+}
+
+bool Traversal::next() {
+    if (!m_started) {
+        start();
+        return !m_done;
+    }
+    while (step()) {
+        if (!m_namedOnly || ts_node_is_named(current())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Traversal::descendLeftmost() {
+    while (ts_tree_cursor_goto_first_child(&m_cursor)) {
+        m_depth++;
+    }
+}
+
+bool Traversal::step() {
+    if (m_done) {
+        return false;
+    }
+
+    const bool skip = m_skip;
+    m_skip = false;
+
+    switch (m_order) {
+    case PreOrder:
+        if (!skip && ts_tree_cursor_goto_first_child(&m_cursor)) {
+            m_depth++;
+            return true;
+        }
+        while (m_depth > 0) {
+            if (ts_tree_cursor_goto_next_sibling(&m_cursor)) {
+                return true;
+            }
+            ts_tree_cursor_goto_parent(&m_cursor);
+            m_depth--;
+        }
+        break;
+    case PostOrder:
+        if (m_depth == 0) {
+            break;
+        }
+        if (ts_tree_cursor_goto_next_sibling(&m_cursor)) {
+            descendLeftmost();
+        } else {
+            ts_tree_cursor_goto_parent(&m_cursor);
+            m_depth--;
+        }
+        return true;
+    case LevelOrder: {
+        const Entry entry = m_queue.front();
+        m_queue.pop_front();
+        if (!skip) {
+            ts_tree_cursor_reset(&m_cursor, entry.node);
+            if (ts_tree_cursor_goto_first_child(&m_cursor)) {
+                do {
+                    m_queue.push_back({
+                        ts_tree_cursor_current_node(&m_cursor),
+                        entry.depth + 1,
+                        ts_tree_cursor_current_field_id(&m_cursor)
+                    });
+                } while (ts_tree_cursor_goto_next_sibling(&m_cursor));
+            }
+        }
+        if (!m_queue.empty()) {
+            return true;
+        }
+        break;
+    }
+    }
+
+    m_done = true;
+    return false;
+}
+
+TSNode Traversal::current() const {
+    if (m_order == LevelOrder) {
+        return m_queue.front().node;
+    }
+    return ts_tree_cursor_current_node(&m_cursor);
+}
+
+Node Traversal::node() const {
+    return Node(m_tree, current());
+}
+
+TSFieldId Traversal::fieldId() const {
+    if (m_order == LevelOrder) {
+        return m_queue.front().field;
+    }
+    return ts_tree_cursor_current_field_id(&m_cursor);
+}
+
+uint32_t Traversal::depth() const {
+    if (m_order == LevelOrder) {
+        return m_queue.front().depth;
+    }
+    return m_depth;
+}
+
+Node Traversal::iterator::operator*() const {
+    return m_traversal->node();
+}
@@ -1,6 +1,10 @@
+#include <cstdlib>
 #include "tree_sitter/cxx/cursor.h"
+#include "tree_sitter/cxx/lines.h"
 #include "tree_sitter/cxx/tree.h"
 #include "tree_sitter/cxx/node.h"
+#include "tree_sitter/cxx/nodemap.h"
+#include "tree_sitter/cxx/positions.h"
 #include "tree_sitter/cxx/lang.h"
 
 using namespace TreeSitter;
@@ -8,7 +12,12 @@ using namespace TreeSitter;
 struct Tree::Private {
     TSTree* tree = nullptr;
     Language lang;
-    std::string source = "";
+    std::shared_ptr<const std::string> source = nullptr;
+    std::shared_ptr<const NodeIndex> nodeIndex = nullptr;
+    std::shared_ptr<const ParentIndex> parentIndex = nullptr;
+    std::shared_ptr<const LineIndex> lineIndex = nullptr;
+    std::shared_ptr<const PositionIndex> positionIndex = nullptr;
+    bool parentIndexEnabled = false;
 };
 
 Tree::Tree(TSTree* tree, Language lang, const std::string &source)
@@ -16,14 +25,30 @@ Tree::Tree(TSTree* tree, Language lang, const std::string &source)
 {
     d->tree = tree;
     d->lang = lang;
-    d->source = source;
+    d->source = std::make_shared<const std::string>(source);
 }
 
 Tree::Tree(const Tree& tree)
-    : d(std::make_unique<Private>(*tree.d)) { }
+    : d(std::make_unique<Private>())
+{
+    d->tree = ts_tree_copy(tree.d->tree);
+    d->lang = tree.d->lang;
+    d->source = tree.d->source;
+    d->parentIndexEnabled = tree.d->parentIndexEnabled;
+}
 
 Tree& Tree::operator=(const Tree &tree) {
-    *d = *tree.d;
+    if (this != &tree) {
+        ts_tree_delete(d->tree);
+        d->tree = ts_tree_copy(tree.d->tree);
+        d->lang = tree.d->lang;
+        d->source = tree.d->source;
+        d->nodeIndex = nullptr;
+        d->parentIndex = nullptr;
+        d->lineIndex = nullptr;
+        d->positionIndex = nullptr;
+        d->parentIndexEnabled = tree.d->parentIndexEnabled;
+    }
     return *this;
 }
 
@@ -33,15 +58,15 @@ Tree::~Tree() {
 
 Tree Tree::copy() {
     auto newTree = ts_tree_copy(d->tree);
-    return Tree(newTree, d->lang, d->source);
+    return Tree(newTree, d->lang, *d->source);
 }
 
 Node Tree::rootNode() const {
     return Node(this, ts_tree_root_node(d->tree));
 }
 
-std::string Tree::source() const {
-    return d->source;
+const std::string& Tree::source() const {
+    return *d->source;
 }
 
 TSTree* Tree::tree() const {
@@ -57,9 +82,13 @@ void Tree::edit(Edit delta) {
     edit.old_end_point = delta.oldEndPosition;
     edit.new_end_point = delta.newEndPosition;
     ts_tree_edit(d->tree, &edit);
+    // Their nodes hold the positions from before the edit.
+    std::atomic_store(&d->nodeIndex, std::shared_ptr<const NodeIndex>());
+    std::atomic_store(&d->parentIndex, std::shared_ptr<const ParentIndex>());
+    std::atomic_store(&d->positionIndex, std::shared_ptr<const PositionIndex>());
 }
 
-Language Tree::language() const {
+const Language& Tree::language() const {
     return d->lang;
 }
 
@@ -68,12 +97,64 @@ Cursor Tree::walk() {
     return node.walk();
 }
 
-std::vector<Range> Tree::getChangedRanges(Tree other) {
+std::vector<Range> Tree::getChangedRanges(const Tree& other) {
     uint32_t range_count;
     std::vector<Range> result;
     TSRange *ranges = ts_tree_get_changed_ranges(d->tree, other.tree(), &range_count);
     for (uint32_t i=0; i<range_count; i++) {
         result.push_back(ranges[i]);
     }
+    free(ranges);
     return result;
 }
+
+std::shared_ptr<const NodeIndex> Tree::nodeIndex() const {
+    auto index = std::atomic_load(&d->nodeIndex);
+    if (!index) {
+        index = std::make_shared<const NodeIndex>(this);
+        std::atomic_store(&d->nodeIndex, index);
+    }
+    return index;
+}
+
+std::shared_ptr<const ParentIndex> Tree::parentIndex() const {
+    auto index = std::atomic_load(&d->parentIndex);
+    if (!index) {
+        index = std::make_shared<const ParentIndex>(nodeIndex());
+        std::atomic_store(&d->parentIndex, index);
+    }
+    return index;
+}
+
+bool Tree::parentIndexEnabled() const {
+    return d->parentIndexEnabled;
+}
+
+void Tree::setParentIndexEnabled(bool enabled) {
+    d->parentIndexEnabled = enabled;
+}
+
+std::shared_ptr<const LineIndex> Tree::lineIndex() const {
+    auto index = std::atomic_load(&d->lineIndex);
+    if (!index) {
+        index = std::make_shared<const LineIndex>(d->source);
+        std::atomic_store(&d->lineIndex, index);
+    }
+    return index;
+}
+
+std::shared_ptr<const PositionIndex> Tree::positionIndex() const {
+    auto index = std::atomic_load(&d->positionIndex);
+    if (!index) {
+        index = std::make_shared<const PositionIndex>(this);
+        std::atomic_store(&d->positionIndex, index);
+    }
+    return index;
+}
+
+Point Tree::convertPoint(Point point, ColumnUnit from, ColumnUnit to) const {
+    if (from == to) {
+        return point;
+    }
+    return lineIndex()->convertPoint(point, from, to);
+}
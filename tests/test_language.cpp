@@ -1,6 +1,10 @@
 #include <string>
 #include "boost/ut.hpp"
 #include "tree_sitter/cxx/lang.h"
+#include "tree_sitter/cxx/parser.h"
+#include "tree_sitter/cxx/node.h"
+#include "tree_sitter/cxx/tree.h"
+#include "tree_sitter/cxx/syntax/javascript.h"
 
 #include <iostream>
 
@@ -31,6 +35,61 @@ int main() {
             expect(JavaScript.fieldIdForName("namezzz") == -1);
             expect(JavaScript.fieldNameForId(-1) == "");
             expect(JavaScript.fieldNameForId(10000) == "");
+            expect(!JavaScript.hasFieldName("namezzz"));
+            expect(!JavaScript.field("namezzz").valid());
+            expect(JavaScript.fieldName(FieldId()) == "");
+        };
+
+        it("detects the language of a file") = [] {
+            expect(Language::detect("src/main.cpp") == Language::Cpp);
+            expect(Language::detect("module.PY") == Language::Python);
+            expect(Language::detect("api.h", "int f(void);") == Language::C);
+            expect(Language::detect("api.h", "namespace a { class B; }") == Language::Cpp);
+            expect(Language::detect("app.tsx") == Language::TSX);
+            expect(Language::detect("run", "#!/usr/bin/env python3\n") == Language::Python);
+            expect(Language::detect("run", "#!/usr/bin/env ts-node\nlet a = <b>x</b>;") == Language::TSX);
+            expect(Language::detect("x.h", "// -*- mode: c++ -*-\nint f(void);") == Language::Cpp);
+            expect(Language::detect("x.txt", "/* vim: set ft=rust: */") == Language::Rust);
+            expect(!Language::detect("README").has_value());
+        };
+
+        it("shares its metadata between instances") = [] {
+            Language a(Language::JavaScript);
+            Language b(Language::JavaScript);
+            Language copy = a;
+            expect(&a.nodeTypes() == &b.nodeTypes());
+            expect(&a.fields() == &copy.fields());
+            expect(a.nodeTypeCount() == static_cast<int>(a.nodeTypes().size()));
+            expect(a.fieldCount() + 1 == static_cast<int>(a.fields().size()));
+
+            const int id = a.idForNodeType("export_statement", true);
+            expect(a.nodeTypes()[id] == "export_statement");
+            expect(a.fields()[a.fieldIdForName("body")] == "body");
+        };
+
+        it("matches the generated symbol and field IDs") = [] {
+            Language lang(Language::JavaScript);
+            expect(JavaScript::SymbolCount == static_cast<uint32_t>(lang.nodeTypeCount()));
+            expect(JavaScript::FieldCount == static_cast<uint32_t>(lang.fieldCount()));
+            expect(JavaScript::Sym::identifier == lang.idForNodeType("identifier", true));
+            expect(JavaScript::Sym::anon_plus == lang.idForNodeType("+", false));
+            expect(JavaScript::Field::body == lang.fieldIdForName("body"));
+
+            Parser parser(Language::JavaScript);
+            auto tree = parser.parse("x10 + 1000");
+            auto sum = tree.rootNode().firstChild().value().firstChild().value();
+            expect(JavaScript::Sym::binary_expression == sum.typeId());
+            expect(JavaScript::Sym::number == sum.childForFieldId(JavaScript::Field::right).value().typeId());
+        };
+
+        it("resolves every field by name") = [] {
+            Language JavaScript(Language::JavaScript);
+            for (int i=1; i<=JavaScript.fieldCount(); i++) {
+                const auto name = JavaScript.fieldNameForId(i);
+                expect(JavaScript.hasFieldName(name));
+                expect(JavaScript.field(name) == FieldId(i));
+                expect(JavaScript.fieldName(FieldId(i)) == name);
+            }
         };
 
         it("converts between the string and integer representations of a node type") = [] {
@@ -46,6 +105,16 @@ int main() {
             expect(std::string("*") == JavaScript.nodeTypeForId(starId));
         };
 
+        it("resolves node type names to a symbol set") = [] {
+            Language JavaScript(Language::JavaScript);
+            const auto symbols = JavaScript.symbolsForTypes({ "identifier", "export_statement", "*" });
+            expect(symbols.contains(JavaScript.idForNodeType("identifier", true)));
+            expect(symbols.contains(JavaScript.idForNodeType("export_statement", true)));
+            expect(symbols.contains(JavaScript.idForNodeType("*", false)));
+            expect(!symbols.contains(JavaScript.idForNodeType("number", true)));
+            expect(!JavaScript.symbolsForTypes({ "nonexistent" }).contains(0));
+        };
+
         it("handles invalid types") = [] {
             Language JavaScript(Language::JavaScript);
 
@@ -1,8 +1,17 @@
+#include <algorithm>
+#include <atomic>
+#include <ranges>
 #include <string>
+#include <type_traits>
+#include <unordered_set>
 #include "boost/ut.hpp"
 #include "tree_sitter/cxx/lang.h"
 #include "tree_sitter/cxx/parser.h"
 #include "tree_sitter/cxx/node.h"
+#include "tree_sitter/cxx/nodemap.h"
+#include "tree_sitter/cxx/typed.h"
+#include "tree_sitter/cxx/typed/javascript.h"
+#include "tree_sitter/cxx/parallel.h"
 #include "tree_sitter/cxx/tree.h"
 
 #include <iostream>
@@ -11,6 +20,8 @@ using namespace boost::ut;
 using namespace boost::ut::spec;
 using namespace TreeSitter;
 
+static_assert(std::ranges::input_range<ChildRange>);
+
 bool operator==(Point rhs, const Point &lhs) {
     return rhs.column == lhs.column && rhs.row == lhs.row;
 }
@@ -44,6 +55,172 @@ int main() {
                 expect("number" == sumNode.namedChildren()[1].type());
             };
         };
+        describe(".childRange and .namedChildRange") = [] {
+            it("lazily iterates over child nodes") = [] {
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("x10 + 1000");
+                const auto sumNode = tree.rootNode()
+                    .firstChild().value()
+                    .firstChild().value();
+                std::vector<std::string> types;
+                for (Node child : sumNode.childRange()) {
+                    types.push_back(child.type());
+                }
+                expect(3 == types.size());
+                expect("identifier" == types[0]);
+                expect("+" == types[1]);
+                expect("number" == types[2]);
+
+                auto named = sumNode.namedChildRange();
+                expect(2 == named.size());
+                expect("identifier" == named.first().value().type());
+                expect("number" == named.last().value().type());
+                auto numbers = named | std::views::filter([](Node child) {
+                    return child.type() == "number";
+                });
+                expect("1000" == (*numbers.begin()).text());
+                static_assert(std::is_trivially_copyable_v<Node>, "nodes are copied without allocating");
+            };
+        };
+        describe(".descendants()") = [] {
+            it("visits named descendants in pre-order, post-order and level-order") = [] {
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("x10 + 1000");
+                const auto collect = [&tree](Traversal::Order order) {
+                    std::vector<std::string> types;
+                    for (Node node : tree.rootNode().descendants(order, true)) {
+                        types.push_back(node.type());
+                    }
+                    return types;
+                };
+                expect(collect(Traversal::PreOrder) == std::vector<std::string>({
+                    "program", "expression_statement", "binary_expression", "identifier", "number"
+                }));
+                expect(collect(Traversal::PostOrder) == std::vector<std::string>({
+                    "identifier", "number", "binary_expression", "expression_statement", "program"
+                }));
+                expect(collect(Traversal::LevelOrder) == std::vector<std::string>({
+                    "program", "expression_statement", "binary_expression", "identifier", "number"
+                }));
+            };
+            it("reports depth and can skip subtrees") = [] {
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("f(a); g(b);");
+                auto walk = tree.rootNode().descendants();
+                std::vector<std::string> visited;
+                uint32_t maxDepth = 0;
+                for (auto it = walk.begin(); it != walk.end(); ++it) {
+                    visited.push_back((*it).text());
+                    maxDepth = std::max(maxDepth, it.depth());
+                    if ((*it).type() == "expression_statement" && (*it).text() == "f(a);") {
+                        it.skipSubtree();
+                    }
+                }
+                expect(std::find(visited.begin(), visited.end(), "a") == visited.end());
+                expect(std::find(visited.begin(), visited.end(), "b") != visited.end());
+                expect(4 == maxDepth);
+            };
+        };
+        describe(".descendantsOfType()") = [] {
+            it("finds descendants of the given types") = [] {
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("a + b;\nc + d;");
+                auto identifiers = tree.rootNode().descendantsOfType("identifier");
+                expect(4 == identifiers.size());
+                expect("a" == identifiers[0].text());
+                expect("d" == identifiers[3].text());
+                auto secondLine = tree.rootNode().descendantsOfType("identifier", Point { 1, 0 });
+                expect(2 == secondLine.size());
+                expect("c" == secondLine[0].text());
+            };
+            it("accepts a precomputed symbol set and a byte range") = [] {
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("a + b;\nc + d;");
+                const auto symbols = tree.language().symbolsForTypes({ "identifier", "number" });
+                auto firstLine = tree.rootNode().descendantsOfType(symbols, 0, 6);
+                expect(2 == firstLine.size());
+                expect("b" == firstLine[1].text());
+
+                std::vector<std::string> visited;
+                tree.rootNode().visitDescendantsOfType(symbols, [&visited](const Node& node) {
+                    visited.push_back(node.text());
+                    return visited.size() < 3;
+                });
+                expect(visited == std::vector<std::string>({ "a", "b", "c" }));
+            };
+        };
+        describe("ParallelTraversal") = [] {
+            it("finds the same descendants as a serial walk, in document order") = [] {
+                Parser parser(Language::JavaScript);
+                std::string source;
+                for (int i=0; i<500; i++) {
+                    source += "function f" + std::to_string(i) + "(a) { return g(a, " + std::to_string(i) + "); }\n";
+                }
+                auto tree = parser.parse(source);
+                const auto symbols = tree.language().symbolsForTypes({ "identifier", "number" });
+                const auto serial = tree.rootNode().descendantsOfType(symbols);
+
+                ParallelTraversal walk(tree.rootNode(), { 4, 1 });
+                expect(walk.partitionCount() > 4);
+                const auto parallel = walk.descendantsOfType(symbols);
+                expect(serial.size() == parallel.size());
+                bool sameOrder = serial.size() == parallel.size();
+                for (size_t i=0; sameOrder && i<serial.size(); i++) {
+                    sameOrder = serial[i].startIndex() == parallel[i].startIndex();
+                }
+                expect(sameOrder);
+                expect(serial.front() == parallel.front()) << "results belong to the tree, not to a copy";
+
+                std::atomic<size_t> count(0);
+                walk.visit([&count](const Node& node, size_t partition) {
+                    count++;
+                }, true);
+                size_t namedCount = 0;
+                for (Node node : tree.rootNode().descendants(Traversal::PreOrder, true)) {
+                    namedCount++;
+                }
+                expect(namedCount == count.load());
+            };
+        };
+        describe(".id() and std::hash") = [] {
+            it("identifies nodes so they can be used as keys") = [] {
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("x10 + 1000");
+                auto sum = tree.rootNode()
+                    .firstChild().value()
+                    .firstChild().value();
+                expect(sum.id() == sum.child(0).value().parent().id());
+                expect(sum.id() != sum.child(0).value().id());
+                expect(sum != sum.child(0).value());
+
+                std::unordered_set<Node> seen;
+                for (Node node : tree.rootNode().descendants()) {
+                    seen.insert(node);
+                }
+                expect(seen.count(sum.child(2).value()) == 1);
+                expect(seen.size() == tree.nodeIndex()->size());
+            };
+        };
+        describe("NodeMap") = [] {
+            it("stores one value per node in pre-order") = [] {
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("x10 + 1000");
+                NodeMap<int> depths(tree, -1);
+                auto walk = tree.rootNode().descendants();
+                size_t i = 0;
+                for (auto it = walk.begin(); it != walk.end(); ++it, ++i) {
+                    expect(depths.index().indexOf(*it) == i);
+                    depths[*it] = it.depth();
+                }
+                auto number = tree.rootNode().descendantsOfType("number")[0];
+                expect(3 == depths[number]);
+                expect(0 == depths.at(0));
+                expect(depths.index().memoryUsage() > 0);
+
+                auto other = parser.parse("y");
+                expect(nullptr == depths.find(other.rootNode()));
+            };
+        };
         describe(".startIndex and .endIndex") = [] {
             it("returns the character index where the node starts/ends in the text") = [] {
                 Parser parser(Language::JavaScript);
@@ -94,6 +271,43 @@ int main() {
                 expect(tree.rootNode() == sumNode.parent());
             };
         };
+        describe(".ancestors() and .depth()") = [] {
+            it("returns the same results with and without the parent index") = [] {
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("f(a + b);");
+                auto b = tree.rootNode().descendantsOfType("identifier")[2];
+                expect("b" == b.text());
+
+                const auto ancestors = b.ancestors();
+                const auto depth = b.depth();
+                const auto parent = b.parent();
+                expect(depth == ancestors.size());
+                expect(tree.rootNode() == ancestors.back());
+                expect("binary_expression" == parent.type());
+
+                tree.setParentIndexEnabled(true);
+                expect(depth == b.depth());
+                expect(parent == b.parent());
+                expect(ancestors == b.ancestors());
+                expect(0 == tree.rootNode().depth());
+                expect(tree.parentIndex()->memoryUsage() > tree.nodeIndex()->memoryUsage());
+            };
+
+            it("does not return stale nodes after an edit") = [] {
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("f(a + b);");
+                tree.setParentIndexEnabled(true);
+                const auto index = tree.parentIndex();
+                expect(2 == tree.rootNode().descendantsOfType("identifier")[2].parent().startIndex());
+
+                tree.edit({ 0, 0, 2, { 0, 0 }, { 0, 0 }, { 0, 2 } });
+                expect(index != tree.parentIndex());
+                auto b = tree.rootNode().descendantsOfType("identifier")[2];
+                expect(4 == b.parent().startIndex());
+                expect(ts_node_start_byte(ts_node_parent(b.node())) == b.parent().startIndex());
+                expect(Point({ 0, 4 }) == b.ancestors()[0].startPosition());
+            };
+        };
         describe(".child()") = [] {
             it("returns null when the node has no children") = [] {
                 Parser parser(Language::JavaScript);
@@ -110,6 +324,35 @@ int main() {
                 expect(false == variableNode.child(1).has_value());
             };
         };
+        describe(".childForFieldName() and .childForField()") = [] {
+            it("returns the child for a field") = [] {
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("x10 + 1000");
+                auto sumNode = tree.rootNode()
+                    .firstChild().value()
+                    .firstChild().value();
+                const FieldId right = tree.language().field("right");
+                expect("1000" == sumNode.childForField(right).value().text());
+                expect("x10" == sumNode.childForFieldName("left").value().text());
+                expect(false == sumNode.childForFieldName("body").has_value());
+                expect(false == sumNode.childForField(FieldId()).has_value());
+            };
+        };
+        describe("TypedNode") = [] {
+            it("wraps nodes of the generated types") = [] {
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("function f(a) { return a; }");
+                TypedNode node(tree.rootNode().firstChild().value());
+
+                expect(false == node.as<JavaScript::StatementBlock>().has_value());
+                auto function = node.as<JavaScript::FunctionDeclaration>();
+                expect(function.has_value());
+                expect("f" == function->name().value().text());
+                expect("(a)" == function->parameters().value().text());
+                expect("{ return a; }" == function->body().value().text());
+                expect(function->body()->node().type() == "statement_block");
+            };
+        };
         describe(".nextSibling and .previousSibling") = [] {
             it("returns the node's next and previous sibling") = [] {
                 Parser parser(Language::JavaScript);
@@ -4,12 +4,20 @@ See https://github.com/tree-sitter/tree-sitter/blob/master/lib/binding_web/test/
 */
 #include <algorithm>
 #include <map>
+#include <optional>
+#include <sstream>
 #include <string>
 #include "boost/ut.hpp"
+#include "tree_sitter/cxx/fusedquery.h"
+#include "tree_sitter/cxx/highlighter.h"
 #include "tree_sitter/cxx/lang.h"
 #include "tree_sitter/cxx/parser.h"
 #include "tree_sitter/cxx/node.h"
 #include "tree_sitter/cxx/query.h"
+#include "tree_sitter/cxx/querycache.h"
+#include "tree_sitter/cxx/queryrunner.h"
+#include "tree_sitter/cxx/symbolindex.h"
+#include "tree_sitter/cxx/tagger.h"
 #include "tree_sitter/cxx/tree.h"
 
 #include <iostream>
@@ -73,5 +81,331 @@ int main() {
                 ) << "Captures wrong number of arguments";
             };
         };
+
+        describe(".captureIndex") = [] {
+            it("resolves capture names to indices") = [] {
+                Language JavaScript(Language::JavaScript);
+                const Query query = JavaScript.query(
+                    "(call_expression function: (identifier) @fn arguments: (arguments (identifier) @arg))");
+                expect(query.captureCount() == 2);
+                expect(query.captureIndex("arg") == std::optional<uint32_t>(1));
+                expect(query.captureName(0) == "fn");
+                expect(!query.captureIndex("missing").has_value());
+
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("f(x)");
+                const auto captures = query.captures(tree.rootNode());
+                expect(captures.size() == 2);
+                expect(captures[1].index == 1);
+                expect(captures[1].name == "arg");
+                expect(captures[1].node.text() == "x");
+            };
+
+            it("filters by predicates on capture indices") = [] {
+                Language JavaScript(Language::JavaScript);
+                const Query query = JavaScript.query("((identifier) @a (#eq? @a \"b\"))");
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("a; b; c; b;");
+                expect(query.matches(tree.rootNode()).size() == 2);
+            };
+
+            it("evaluates #match? and #not-eq? on the node text") = [] {
+                Language JavaScript(Language::JavaScript);
+                const Query query = JavaScript.query(
+                    "((identifier) @constant (#match? @constant \"^[A-Z][A-Z_0-9]*$\"))"
+                    "((assignment_expression left: (identifier) @l right: (identifier) @r) (#not-eq? @l @r))");
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("MAX_SIZE; maxSize; a = a; b = c;");
+                const auto matches = query.matches(tree.rootNode());
+                expect(matches.size() == 2);
+                expect(matches[0].captures[0].node.text() == "MAX_SIZE");
+                expect(matches[1].captures[0].node.text() == "b");
+            };
+        };
+
+        describe(".registerPredicate") = [] {
+            it("evaluates #any-of? and custom predicates while matching") = [] {
+                Query::registerPredicate("longer-than?", [](const Query::MatchView& match, const std::vector<Query::Argument>& args) {
+                    const size_t length = std::stoul(std::string(args[1].value));
+                    for (uint32_t i = match.find(args[0].capture); i < match.size(); i = match.find(args[0].capture, i + 1)) {
+                        if (match.text(i).size() <= length) {
+                            return false;
+                        }
+                    }
+                    return true;
+                });
+                Language JavaScript(Language::JavaScript);
+                const Query query = JavaScript.query(
+                    "((identifier) @builtin (#any-of? @builtin \"window\" \"document\"))"
+                    "((identifier) @long (#longer-than? @long \"8\"))");
+                expect(query.predicatesForPattern(1).empty());
+
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("window; x; document; averyLongName;");
+                const auto captures = query.captures(tree.rootNode());
+                expect(captures.size() == 3);
+                expect(captures[0].name == "builtin");
+                expect(captures[2].node.text() == "averyLongName");
+            };
+        };
+
+        describe("QueryCursor") = [] {
+            it("runs one query over several trees") = [] {
+                Language JavaScript(Language::JavaScript);
+                const Query query = JavaScript.query("(number) @n");
+                Parser parser(Language::JavaScript);
+                auto first = parser.parse("x + 1");
+                auto second = parser.parse("[1, 2, 3]");
+
+                QueryCursor cursor;
+                expect(cursor.captures(query, first.rootNode()).size() == 1);
+                expect(cursor.captures(query, second.rootNode()).size() == 3);
+                expect(!cursor.didExceedMatchLimit());
+
+                cursor.setByteRange(3, 0);
+                expect(cursor.captures(query, second.rootNode()).size() == 2);
+                expect(query.captures(second.rootNode()).size() == 3) << "const query, own cursor";
+            };
+
+            it("does not keep the settings of a pooled cursor") = [] {
+                Language JavaScript(Language::JavaScript);
+                const Query query = JavaScript.query("(number) @n");
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("[1, 2, 3]");
+                {
+                    QueryCursor cursor;
+                    cursor.setByteRange(3, 0);
+                    expect(cursor.captures(query, tree.rootNode()).size() == 2);
+                }
+                QueryCursor cursor;
+                expect(cursor.captures(query, tree.rootNode()).size() == 3);
+            };
+
+            it("pulls matches lazily") = [] {
+                Language JavaScript(Language::JavaScript);
+                const Query query = JavaScript.query("(number) @n");
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("1; 2; 3;");
+
+                const auto matches = query.matches(tree.rootNode());
+                expect(matches.size() == 3);
+                expect(matches[0].captures.size() == 1) << "no empty matches in front";
+
+                QueryCursor cursor;
+                int seen = 0;
+                for (const Query::Match& match : cursor.eachMatch(query, tree.rootNode())) {
+                    expect(match.captures[0].node.text() == "1");
+                    seen++;
+                    break;
+                }
+                expect(seen == 1);
+                expect(cursor.nextMatch() != nullptr) << "the run continues after break";
+                expect(cursor.nextMatch() != nullptr);
+                expect(cursor.nextMatch() == nullptr);
+            };
+        };
+
+        describe("QueryRunner") = [] {
+            it("runs one query over many trees") = [] {
+                Language JavaScript(Language::JavaScript);
+                Parser parser(Language::JavaScript);
+                std::vector<Tree> trees;
+                for (int i=0; i<16; i++) {
+                    trees.push_back(parser.parse(std::string(i, ';') + "f(" + std::to_string(i) + ", x);"));
+                }
+                const Query query = JavaScript.query("(number) @n (identifier) @id");
+                QueryRunner runner(query, { 4 });
+                const auto inputs = QueryRunner::fromTrees(trees);
+
+                const auto captures = runner.captures(inputs);
+                expect(captures.size() == 48);
+                expect(captures[3].input == 1);
+                expect(query.captureName(captures[4].index) == "n");
+                expect(captures[4].startIndex == 3);
+
+                const auto counts = runner.countCaptures(inputs);
+                expect(counts[0] == 16);
+                expect(counts[1] == 32);
+
+                expect(throws([&runner] { runner.countCaptures(QueryRunner::fromFiles({ "/nonexistent/file.js" })); }));
+            };
+        };
+
+        describe("FusedQuery") = [] {
+            it("splits results per query") = [] {
+                Language JavaScript(Language::JavaScript);
+                Parser parser(Language::JavaScript);
+                Tree tree = parser.parse("f(1, x);");
+                FusedQuery fused({
+                    JavaScript.query("(number) @n"),
+                    JavaScript.query("(identifier) @id (number) @num"),
+                });
+                expect(fused.queryCount() == 2);
+                expect(fused.fused().patternCount() == 3);
+
+                const auto matches = fused.matches(tree.rootNode());
+                expect(matches[0].size() == 1);
+                expect(matches[1].size() == 3);
+                const auto number = std::find_if(matches[1].begin(), matches[1].end(), [](const Query::Match& match) {
+                    return match.pattern == 1;
+                });
+                expect(number != matches[1].end());
+                expect(number->captures[0].index == 1);
+                expect(number->captures[0].name == "num");
+
+                const auto captures = fused.captures(tree.rootNode());
+                expect(captures[0].size() == 1);
+                expect(captures[0][0].index == 0);
+                expect(captures[1].size() == 3);
+                expect(captures[1][0].node.text() == "f");
+
+                expect(throws([&JavaScript] {
+                    FusedQuery({ JavaScript.query("(number) @n"), Language(Language::Python).query("(integer) @n") });
+                }));
+            };
+        };
+
+        describe("Highlighter") = [] {
+            it("resolves nesting, priority and injections") = [] {
+                Language JavaScript(Language::JavaScript);
+                Parser parser(Language::JavaScript);
+                Tree tree = parser.parse("f(A, \"1+2\");");
+                Highlighter::Config config = {
+                    JavaScript.query(
+                        "(call_expression function: (identifier) @function)"
+                        "((identifier) @constant (#match? @constant \"^[A-Z]\"))"
+                        "(identifier) @variable"
+                        "(string) @string"
+                        "(number) @number"),
+                    JavaScript.query("((string_fragment) @injection.content (#set! injection.language \"javascript\"))"),
+                };
+                Highlighter highlighter({ "function", "constant", "variable", "string", "number" }, config);
+
+                auto spans = highlighter.highlight(tree);
+                expect(spans.size() == 3);
+                expect(spans[0] == Highlighter::Span { 0, 1, 0 });
+                expect(spans[1] == Highlighter::Span { 2, 3, 1 });
+                expect(spans[2] == Highlighter::Span { 5, 10, 3 });
+
+                highlighter.addInjection("javascript", config);
+                spans = highlighter.highlight(tree);
+                expect(spans.size() == 7);
+                expect(spans[3] == Highlighter::Span { 6, 7, 4 }) << "injected text overrides the string";
+                expect(spans[4] == Highlighter::Span { 7, 8, 3 });
+
+                spans = highlighter.highlight(tree, 7, 20);
+                expect(spans.size() == 3);
+                expect(spans[0] == Highlighter::Span { 7, 8, 3 });
+            };
+
+            it("updates the spans after an edit") = [] {
+                Language JavaScript(Language::JavaScript);
+                Parser parser(Language::JavaScript);
+                Highlighter highlighter({ "variable", "number" }, { JavaScript.query("(identifier) @variable (number) @number") });
+                Tree tree = parser.parse("f(1);\ng(2);\n");
+                auto spans = highlighter.highlight(tree);
+
+                const Edit edit = { 6, 6, 12, { 1, 0 }, { 1, 0 }, { 2, 0 } };
+                tree.edit(edit);
+                Tree newTree = parser.parse(tree, "f(1);\nh(3);\ng(2);\n");
+                const auto updates = highlighter.update(tree, newTree, edit);
+                expect(!updates.empty());
+                expect(updates[0].startIndex >= 6) << "the first line did not change";
+
+                Highlighter::apply(spans, edit, updates);
+                expect(spans == highlighter.highlight(newTree));
+            };
+        };
+
+        describe("Tagger") = [] {
+            it("extracts definitions and references") = [] {
+                Language JavaScript(Language::JavaScript);
+                Parser parser(Language::JavaScript);
+                Tree tree = parser.parse("// Adds.\n// Two numbers.\nfunction add(a, b) { return a + b; }\nadd(1, 2);\n");
+                Tagger tagger(JavaScript.query(
+                    "((comment)* @doc . (function_declaration name: (identifier) @name) @definition.function"
+                    " (#strip! @doc \"^//\\\\s*\") (#select-adjacent! @doc @definition.function))"
+                    "(call_expression function: (identifier) @name) @reference.call"));
+
+                const auto tags = tagger.tags(tree);
+                expect(tags.size() == 2);
+                expect(tags[0].name == "add");
+                expect(tags[0].kind == "function");
+                expect(tags[0].definition);
+                expect(tags[0].range.start_point.row == 2);
+                expect(tags[0].docs == "Adds.\nTwo numbers.");
+                expect(tags[1].kind == "call");
+                expect(!tags[1].definition);
+                expect(tags[1].nameRange.start_point.row == 3);
+            };
+        };
+
+        describe("SymbolIndex") = [] {
+            it("updates files and finds names by prefix") = [] {
+                Language JavaScript(Language::JavaScript);
+                Parser parser(Language::JavaScript);
+                Tagger tagger(JavaScript.query("(function_declaration name: (identifier) @name) @definition.function"));
+                SymbolIndex index;
+                index.update("a.js", 1, tagger.tags(parser.parse("function parse() {}\nfunction print() {}")));
+                index.update("b.js", 1, tagger.tags(parser.parse("function parseAll() {}")));
+                expect(index.size() == 3);
+                expect(index.findPrefix("par").size() == 2);
+                expect(index.findPrefix("p", 1).size() == 1);
+
+                index.update("a.js", 2, tagger.tags(parser.parse("function print() {}")));
+                expect(index.size() == 2);
+                expect(index.find("parse").empty());
+                expect(*index.stamp("a.js") == 2);
+
+                std::stringstream data;
+                index.save(data);
+                SymbolIndex loaded = SymbolIndex::load(data);
+                expect(loaded.files() == std::vector<std::string> { "a.js", "b.js" });
+                const auto symbols = loaded.find("parseAll");
+                expect(symbols.size() == 1);
+                expect(symbols[0].path == "b.js");
+                expect(symbols[0].tag.nameRange.start_byte == 9);
+
+                std::stringstream garbage("not an index");
+                expect(throws([&garbage] { SymbolIndex::load(garbage); }));
+            };
+        };
+
+        describe("QueryCache") = [] {
+            it("compiles each query once") = [] {
+                Language JavaScript(Language::JavaScript);
+                QueryCache cache(1);
+                cache.get(JavaScript, "(identifier) @name");
+                Query query = cache.get(JavaScript, "(identifier) @name");
+                expect(query.captureNames().size() == 1);
+                expect(cache.stats().hits == 1);
+                expect(cache.stats().misses == 1);
+
+                cache.get(JavaScript, "(number) @n");
+                expect(cache.stats().evictions == 1);
+                expect(cache.stats().size == 1);
+                expect(query.captureNames().size() == 1) << "copies outlive eviction";
+
+                expect(throws([&cache, &JavaScript] { cache.get(JavaScript, "(non_existent)"); }));
+                expect(cache.stats().size == 1);
+            };
+
+            it("compiles queries again after a predicate is registered") = [] {
+                Language JavaScript(Language::JavaScript);
+                const std::string source = "((identifier) @a (#is-cached-x? @a))";
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("x; y;");
+                QueryCache cache;
+                expect(cache.get(JavaScript, source).captures(tree.rootNode()).size() == 2);
+
+                Query::registerPredicate("is-cached-x?", [](const Query::MatchView& match, const std::vector<Query::Argument>& args) {
+                    return match.text(match.find(args[0].capture)) == "x";
+                });
+                const auto captures = cache.get(JavaScript, source).captures(tree.rootNode());
+                expect(captures.size() == 1);
+                expect(captures[0].node.text() == "x");
+                expect(cache.stats().misses == 2);
+            };
+        };
     };
 }
@@ -0,0 +1,133 @@
+#include <regex>
+#include <string>
+#include <vector>
+#include "boost/ut.hpp"
+#include "regex.h"
+
+using namespace boost::ut;
+using namespace boost::ut::spec;
+using TreeSitter::Internal::Regex;
+
+namespace {
+
+struct Case {
+    std::string pattern;
+    /** Whether the DFA handles the pattern, or std::regex does. */
+    bool compiled;
+    std::vector<std::string> texts;
+};
+
+/** Search every text with Regex and with std::regex; they must agree. */
+void check(const std::vector<Case>& cases) {
+    for (const Case& c : cases) {
+        const Regex regex(c.pattern);
+        const std::regex expected(c.pattern, std::regex::ECMAScript);
+        expect(c.compiled == regex.compiled()) << c.pattern;
+        for (const std::string& text : c.texts) {
+            expect(std::regex_search(text, expected) == regex.search(text)) << c.pattern << "on" << text;
+        }
+    }
+}
+
+}
+
+int main() {
+    describe("Regex") = [] {
+        describe(".search()") = [] {
+            it("matches character classes and negated classes") = [] {
+                check({
+                    { "[a-c]+", true, { "", "abc", "xyz", "xbz" } },
+                    { "^[^a-c]+$", true, { "", "abc", "xyz", "xbz", "\xc3\xa9" } },
+                    { "[-a]", true, { "-", "a", "b" } },
+                    { "[a-]", true, { "-", "a", "b" } },
+                    { "[\\]x]", true, { "]", "x", "y" } },
+                    { "[.]", true, { ".", "a" } },
+                    { "[\\d_]+$", true, { "a_1", "a-", "" } },
+                    { "[^\\s]", true, { " \t\n", " a " } },
+                    { "[\\b]", true, { "\b", "b" } },
+                    { "[\\x41-\\x43]", true, { "B", "D" } },
+                });
+            };
+
+            it("matches \\d, \\w, \\s and their complements") = [] {
+                check({
+                    { "\\d", true, { "abc", "a1c" } },
+                    { "^\\D+$", true, { "abc", "a1c", "" } },
+                    { "\\w", true, { "  ", " _ ", " a ", " 9 " } },
+                    { "^\\W+$", true, { " -+", " a ", "" } },
+                    { "\\s", true, { "ab", "a b", "a\tb", "a\nb", "a\rb", "a\fb", "a\vb" } },
+                    { "^\\S+$", true, { "ab", "a b", "a\nb" } },
+                });
+            };
+
+            it("does not match . against line breaks") = [] {
+                check({
+                    { "a.b", true, { "axb", "a\nb", "a\rb", "a\tb", "ab" } },
+                    { "^.*$", true, { "", "abc", "a\nb" } },
+                    { "^.+$", true, { "", "\n", "\r", "x" } },
+                });
+            };
+
+            it("matches anchors anywhere in the pattern") = [] {
+                check({
+                    { "a^b", true, { "ab", "a^b", "" } },
+                    { "a$b", true, { "ab", "a$b" } },
+                    { "a|^b", true, { "b", "cb", "ca", "" } },
+                    { "(^a|b)c", true, { "ac", "xac", "xbc", "c" } },
+                    { "a$|b", true, { "a", "ab", "xb", "" } },
+                    { "^$", true, { "", "a", "\n" } },
+                    { "(a|^)b", true, { "b", "ab", "cb" } },
+                });
+            };
+
+            it("matches empty alternatives and groups") = [] {
+                check({
+                    { "a|", true, { "", "b", "a" } },
+                    { "|a", true, { "", "b" } },
+                    { "^(|b)c$", true, { "c", "bc", "bbc" } },
+                    { "()", true, { "", "a" } },
+                    { "^a()b$", true, { "ab", "a b" } },
+                    { "^(?:a|b)+$", true, { "abba", "abc", "" } },
+                });
+            };
+
+            it("matches counted and lazy repetition") = [] {
+                check({
+                    { "^a{2}$", true, { "a", "aa", "aaa" } },
+                    { "^a{2,}$", true, { "a", "aa", "aaaaaa", "" } },
+                    { "^a{2,3}$", true, { "a", "aa", "aaa", "aaaa" } },
+                    { "^(ab){2}$", true, { "ab", "abab", "ababab" } },
+                    { "x{0}y", true, { "y", "xy", "x" } },
+                    { "a+?b", true, { "aab", "b" } },
+                    { "^a*?$", true, { "", "aaa", "ab" } },
+                });
+            };
+
+            it("prefilters on the literal every match contains") = [] {
+                check({
+                    { "hello", true, { "hello", "say hello!", "hell", "" } },
+                    { "foo\\d+bar", true, { "foo12bar", "foobar", "foo1baz", "xx", "bar foo1bar" } },
+                    { "^(ab|cd)ef", true, { "abef", "cdef", "xabef", "ef" } },
+                    { "a\\.b", true, { "a.b", "axb" } },
+                });
+            };
+
+            it("falls back to std::regex for what the DFA cannot express") = [] {
+                check({
+                    { "\\bfoo\\b", false, { "foo", "a foo b", "foobar" } },
+                    { "(a)\\1", false, { "aa", "ab" } },
+                    { "a(?=b)", false, { "ab", "ac" } },
+                    { "a(?!b)", false, { "ab", "ac" } },
+                    { "^[[:alpha:]]+$", false, { "abc", "ab1" } },
+                    { "a{1000}", false, { "a", std::string(1000, 'a') } },
+                });
+            };
+
+            it("throws on invalid patterns") = [] {
+                for (const std::string pattern : { "(", "a)", "[a", "a{", "a{2,1}", "[b-a]", "*a", "\\" }) {
+                    expect(throws<std::regex_error>([&] { Regex regex(pattern); })) << pattern;
+                }
+            };
+        };
+    };
+}
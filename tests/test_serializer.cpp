@@ -0,0 +1,62 @@
+#include <sstream>
+#include <string>
+#include "boost/ut.hpp"
+#include "tree_sitter/cxx/lang.h"
+#include "tree_sitter/cxx/parser.h"
+#include "tree_sitter/cxx/node.h"
+#include "tree_sitter/cxx/serializer.h"
+#include "tree_sitter/cxx/tree.h"
+
+using namespace boost::ut;
+using namespace boost::ut::spec;
+using namespace TreeSitter;
+
+int main() {
+    describe("Serializer") = [] {
+        describe(".write()") = [] {
+            it("writes the same S-expression as Node.sexpr()") = [] {
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("x10 + 1000");
+                auto root = tree.rootNode();
+                Serializer serializer;
+                expect(root.sexpr() == serializer.toString(root));
+            };
+            it("writes JSON to a stream") = [] {
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("x10 + 1000");
+                Serializer serializer({ Serializer::JSON, true, true, true, true });
+                std::ostringstream out;
+                serializer.write(tree.rootNode(), out);
+                const std::string json = out.str();
+                expect(0 == json.find("{\"type\":\"program\""));
+                expect(std::string::npos != json.find("\"field\":\"left\""));
+                expect(std::string::npos != json.find("\"text\":\"1000\""));
+                expect(std::string::npos != json.find("{\"type\":\"+\",\"named\":false"));
+                expect(std::string::npos != json.find("\"endPosition\":{\"row\":0,\"column\":10}"));
+            };
+            it("writes XML in chunks to a sink") = [] {
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("a < b");
+                Serializer serializer({ Serializer::XML, true, false, true, true });
+                std::string xml;
+                int chunks = 0;
+                serializer.write(tree.rootNode(), [&xml, &chunks](const char* data, size_t length) {
+                    xml.append(data, length);
+                    chunks++;
+                });
+                expect(chunks > 0);
+                expect(std::string::npos != xml.find("<identifier field=\"left\">a</identifier>"));
+                expect(std::string::npos != xml.find("<anonymous type=\"&lt;\">&lt;</anonymous>"));
+            };
+            it("replaces control characters in XML text") = [] {
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("x = 'a\fb\x01" "c\td';");
+                Serializer serializer({ Serializer::XML, true, false, true, true });
+                const std::string xml = serializer.toString(tree.rootNode());
+                expect(std::string::npos != xml.find("a\xef\xbf\xbd" "b\xef\xbf\xbd" "c\td"));
+                expect(std::string::npos == xml.find('\f'));
+                expect(std::string::npos == xml.find('\x01'));
+            };
+        };
+    };
+}
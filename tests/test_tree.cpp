@@ -0,0 +1,105 @@
+#include <string>
+#include <vector>
+#include "boost/ut.hpp"
+#include "tree_sitter/cxx/lang.h"
+#include "tree_sitter/cxx/lines.h"
+#include "tree_sitter/cxx/parser.h"
+#include "tree_sitter/cxx/node.h"
+#include "tree_sitter/cxx/positions.h"
+#include "tree_sitter/cxx/tree.h"
+
+#include <iostream>
+
+using namespace boost::ut;
+using namespace boost::ut::spec;
+using namespace TreeSitter;
+
+bool operator==(Point rhs, const Point &lhs) {
+    return rhs.column == lhs.column && rhs.row == lhs.row;
+}
+
+int main() {
+    describe("Tree") = [] {
+        describe(".lineIndex()") = [] {
+            it("converts between offsets and positions") = [] {
+                Parser parser(Language::JavaScript);
+                std::string source = "let a = 1;\r\nlet bb = 2;\n\n";
+                for (int i=0; i<20; i++) {
+                    source += "x" + std::to_string(i) + ";\n";
+                }
+                auto tree = parser.parse(source);
+                auto lines = tree.lineIndex();
+
+                expect(24 == lines->lineCount());
+                expect("let a = 1;" == lines->line(0));
+                expect("let bb = 2;" == lines->line(1));
+                expect("" == lines->line(2));
+                expect("x19;" == lines->line(22));
+                expect("" == lines->line(23));
+
+                for (Node node : tree.rootNode().descendants()) {
+                    expect(node.startPosition() == lines->offsetToPoint(node.startIndex()));
+                    expect(node.endIndex() == lines->pointToOffset(node.endPosition()));
+                }
+
+                expect(Point({ 1, 0 }) == lines->offsetToPoint(12));
+                expect(10 == lines->pointToOffset(Point({ 0, 10 })));
+                expect(12 == lines->lineStart(1));
+                expect(lines->lineEnd(0) == lines->pointToOffset(Point({ 0, 500 })));
+                expect(source.size() == lines->pointToOffset(Point({ 500, 0 })));
+            };
+
+            it("converts columns to UTF-16 and code points") = [] {
+                Parser parser(Language::JavaScript);
+                auto tree = parser.parse("s = '\xF0\x9F\x91\x8D\xC3\xA9';\nt = 1;");
+                auto lines = tree.lineIndex();
+
+                expect(!lines->isAscii(0));
+                expect(lines->isAscii(1));
+                expect(8 == lines->convertColumn(0, 11, ColumnUnit::Bytes, ColumnUnit::UTF16));
+                expect(7 == lines->convertColumn(0, 11, ColumnUnit::Bytes, ColumnUnit::CodePoints));
+                expect(11 == lines->convertColumn(0, 8, ColumnUnit::UTF16, ColumnUnit::Bytes));
+                expect(8 == lines->convertColumn(0, 7, ColumnUnit::CodePoints, ColumnUnit::UTF16));
+                // Inside the emoji, and inside its surrogate pair.
+                expect(5 == lines->convertColumn(0, 7, ColumnUnit::Bytes, ColumnUnit::UTF16));
+                expect(5 == lines->convertColumn(0, 6, ColumnUnit::UTF16, ColumnUnit::Bytes));
+                expect(10 == lines->convertColumn(0, 500, ColumnUnit::Bytes, ColumnUnit::UTF16));
+                expect(6 == lines->convertColumn(1, 500, ColumnUnit::Bytes, ColumnUnit::UTF16));
+
+                auto string = tree.rootNode().namedDescendantForPosition(Point({ 0, 4 }));
+                expect(Point({ 0, 9 }) == string.endPosition(ColumnUnit::UTF16));
+                expect(Point({ 0, 12 }) == string.endPosition());
+                expect(Point({ 0, 9 }) == tree.convertPoint(Point({ 0, 12 }), ColumnUnit::Bytes, ColumnUnit::UTF16));
+            };
+        };
+
+        describe(".positionIndex()") = [] {
+            it("matches descending from the root") = [] {
+                Parser parser(Language::JavaScript);
+                std::string source = "  function f(a, b) {\n  return a + b;\n}\nf(1, 2);\n";
+                auto tree = parser.parse(source);
+                auto root = tree.rootNode();
+                auto index = tree.positionIndex();
+
+                std::vector<Point> positions;
+                for (uint32_t row=0; row<6; row++) {
+                    for (uint32_t column=0; column<24; column++) {
+                        positions.push_back(Point({ row, column }));
+                    }
+                }
+                auto nodes = index->descendantsForPositions(positions);
+                auto named = index->namedDescendantsForPositions(positions);
+                for (size_t i=0; i<positions.size(); i++) {
+                    expect(root.descendantForPosition(positions[i]) == nodes[i]);
+                    expect(root.namedDescendantForPosition(positions[i]) == named[i]);
+                    expect(nodes[i] == index->descendantForPosition(positions[i]));
+                }
+
+                std::vector<Point> unsorted = { Point({ 3, 4 }), Point({ 0, 11 }) };
+                auto found = index->namedDescendantsForPositions(unsorted);
+                expect("arguments" == found[0].type());
+                expect("identifier" == found[1].type());
+            };
+        };
+    };
+}
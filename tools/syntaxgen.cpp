@@ -0,0 +1,753 @@
+/**
+ * Generates headers for every built-in grammar:
+ *
+ *  - `tree_sitter/cxx/syntax/<language>.h`, with the symbol and field IDs
+ *    of its parser tables as constants.
+ *  - `tree_sitter/cxx/typed/<language>.h`, with a TypedNode subclass for
+ *    every named node type in its `node-types.json`.
+ *
+ * Usage: tree-sitter-syntaxgen <output directory> <grammar directory>
+ *
+ * The output directory is the one holding `syntax/` and `typed/`. The
+ * grammar directory is where the grammar repositories are checked out.
+ */
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "tree_sitter/api.h"
+#include "tree_sitter/langs.h"
+
+namespace {
+
+struct Grammar {
+    const TSLanguage* (*language)();
+    /** Namespace and title used in the header. */
+    const char* name;
+    /** File name, without extension. */
+    const char* file;
+    /** Path of `node-types.json` in the grammar directory. */
+    const char* nodeTypes;
+};
+
+const Grammar GRAMMARS[] = {
+    { tree_sitter_c, "C", "c", "tree-sitter-c/src/node-types.json" },
+    { tree_sitter_cpp, "Cpp", "cpp", "tree-sitter-cpp/src/node-types.json" },
+    { tree_sitter_c_sharp, "CSharp", "csharp", "tree-sitter-c-sharp/src/node-types.json" },
+    { tree_sitter_go, "Go", "go", "tree-sitter-go/src/node-types.json" },
+    { tree_sitter_java, "Java", "java", "tree-sitter-java/src/node-types.json" },
+    { tree_sitter_javascript, "JavaScript", "javascript", "tree-sitter-javascript/src/node-types.json" },
+    { tree_sitter_python, "Python", "python", "tree-sitter-python/src/node-types.json" },
+    { tree_sitter_rust, "Rust", "rust", "tree-sitter-rust/src/node-types.json" },
+    { tree_sitter_typescript, "TypeScript", "typescript", "tree-sitter-typescript/typescript/src/node-types.json" },
+    { tree_sitter_tsx, "TSX", "tsx", "tree-sitter-typescript/tsx/src/node-types.json" },
+};
+
+/** Names that generated classes must not use. */
+const std::set<std::string> RESERVED_CLASSES = {
+    "Sym", "Field", "Version", "SymbolCount", "FieldCount", "TypedNode",
+};
+
+/** Members of TypedNode that field accessors must not hide. */
+const std::set<std::string> RESERVED_MEMBERS = {
+    "tree", "raw", "node", "is", "as", "typeId", "type", "startIndex",
+    "endIndex", "startPosition", "endPosition", "text", "fieldChild",
+    "fieldChildren", "Symbol",
+};
+
+const std::set<std::string_view> CXX_KEYWORDS = {
+    "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor",
+    "bool", "break", "case", "catch", "char", "char8_t", "char16_t",
+    "char32_t", "class", "compl", "concept", "const", "consteval",
+    "constexpr", "constinit", "const_cast", "continue", "co_await",
+    "co_return", "co_yield", "decltype", "default", "delete", "do", "double",
+    "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false",
+    "float", "for", "friend", "goto", "if", "inline", "int", "long",
+    "mutable", "namespace", "new", "noexcept", "not", "not_eq", "nullptr",
+    "operator", "or", "or_eq", "private", "protected", "public", "register",
+    "reinterpret_cast", "requires", "return", "short", "signed", "sizeof",
+    "static", "static_assert", "static_cast", "struct", "switch", "template",
+    "this", "thread_local", "throw", "true", "try", "typedef", "typeid",
+    "typename", "union", "unsigned", "using", "virtual", "void", "volatile",
+    "wchar_t", "while", "xor", "xor_eq",
+    // Common macros that would break the generated enums.
+    "NULL", "EOF", "TRUE", "FALSE", "ERROR",
+};
+
+/** Name used for punctuation in anonymous node types. */
+const char* punctuationName(char c) {
+    switch (c) {
+    case '!': return "bang";
+    case '"': return "dquote";
+    case '#': return "hash";
+    case '$': return "dollar";
+    case '%': return "percent";
+    case '&': return "amp";
+    case '\'': return "squote";
+    case '(': return "lparen";
+    case ')': return "rparen";
+    case '*': return "star";
+    case '+': return "plus";
+    case ',': return "comma";
+    case '-': return "dash";
+    case '.': return "dot";
+    case '/': return "slash";
+    case ':': return "colon";
+    case ';': return "semi";
+    case '<': return "lt";
+    case '=': return "eq";
+    case '>': return "gt";
+    case '?': return "qmark";
+    case '@': return "at";
+    case '[': return "lbrack";
+    case '\\': return "bslash";
+    case ']': return "rbrack";
+    case '^': return "caret";
+    case '`': return "backtick";
+    case '{': return "lbrace";
+    case '|': return "pipe";
+    case '}': return "rbrace";
+    case '~': return "tilde";
+    case ' ': return "space";
+    case '\t': return "tab";
+    case '\n': return "newline";
+    case '\r': return "cr";
+    default: return nullptr;
+    }
+}
+
+bool isIdentifierChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+/**
+ * Turn a node type or field name into a C++ identifier.
+ *
+ * Identifier characters are kept and punctuation is spelled out, so
+ * `+=` becomes `plus_eq`. Anonymous node types get an `anon_` prefix,
+ * which keeps keywords such as `if` apart from named nodes.
+ */
+std::string mangle(std::string_view name, bool anonymous) {
+    std::string result = anonymous ? "anon" : "";
+    bool inWord = false;
+    for (const char c : name) {
+        if (isIdentifierChar(c)) {
+            if (!inWord && !result.empty() && result.back() != '_') {
+                result += '_';
+            }
+            result += c;
+            inWord = true;
+            continue;
+        }
+        if (!result.empty() && result.back() != '_') {
+            result += '_';
+        }
+        const char* spelled = punctuationName(c);
+        if (spelled != nullptr) {
+            result += spelled;
+        } else {
+            char hex[8];
+            std::snprintf(hex, sizeof(hex), "x%02x", static_cast<unsigned char>(c));
+            result += hex;
+        }
+        inWord = false;
+    }
+    if (result.empty()) {
+        result = "empty";
+    }
+    if (std::isdigit(static_cast<unsigned char>(result[0]))) {
+        result = "_" + result;
+    }
+    if (CXX_KEYWORDS.count(result) > 0) {
+        result += '_';
+    }
+    return result;
+}
+
+/** Quote a name as a C string, for comments. */
+std::string quote(std::string_view name) {
+    std::string result = "\"";
+    for (const char c : name) {
+        switch (c) {
+        case '"': result += "\\\""; break;
+        case '\\': result += "\\\\"; break;
+        case '\n': result += "\\n"; break;
+        case '\r': result += "\\r"; break;
+        case '\t': result += "\\t"; break;
+        default: result += c;
+        }
+    }
+    return result + "\"";
+}
+
+/** Make `name` unique within `taken`, using `id` to break ties. */
+std::string uniqueName(std::string name, unsigned id, std::set<std::string>& taken) {
+    if (taken.count(name) > 0) {
+        name += "_" + std::to_string(id);
+    }
+    taken.insert(name);
+    return name;
+}
+
+/** A symbol or field and the identifier it was given. */
+struct Entry {
+    std::string name;
+    bool named;
+    unsigned id;
+    std::string identifier;
+};
+
+/** Identifiers of every visible symbol and field of a grammar. */
+struct SymbolTable {
+    std::vector<Entry> symbols;
+    std::vector<Entry> fields;
+
+    const Entry* symbol(const std::string& name, bool named) const {
+        for (const Entry& entry : symbols) {
+            if (entry.name == name && entry.named == named) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    const Entry* field(const std::string& name) const {
+        for (const Entry& entry : fields) {
+            if (entry.name == name) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+};
+
+SymbolTable buildSymbolTable(const TSLanguage* lang) {
+    SymbolTable table;
+
+    // Node.typeId() reports the canonical ID of a name, so aliases and
+    // duplicate symbols are listed once, with that ID.
+    std::set<std::string> taken = { "ERROR_" };
+    std::set<TSSymbol> seen;
+    const uint32_t symbolCount = ts_language_symbol_count(lang);
+    for (uint32_t i=0; i<symbolCount; i++) {
+        const TSSymbol symbol = static_cast<TSSymbol>(i);
+        const TSSymbolType type = ts_language_symbol_type(lang, symbol);
+        const char* symbolName = ts_language_symbol_name(lang, symbol);
+        if (type == TSSymbolTypeAuxiliary || symbolName == nullptr) {
+            continue;
+        }
+        const std::string name = symbolName;
+        const bool named = type == TSSymbolTypeRegular;
+        const TSSymbol canonical = ts_language_symbol_for_name(
+            lang, name.c_str(), static_cast<uint32_t>(name.size()), named);
+        if (canonical == 0 || !seen.insert(canonical).second) {
+            continue;
+        }
+        table.symbols.push_back({ name, named, canonical,
+            uniqueName(mangle(name, !named), canonical, taken) });
+    }
+
+    taken.clear();
+    // Field IDs start at 1.
+    const uint32_t fieldCount = ts_language_field_count(lang);
+    for (uint32_t i=1; i<=fieldCount; i++) {
+        const char* name = ts_language_field_name_for_id(lang, static_cast<TSFieldId>(i));
+        if (name != nullptr && *name != '\0') {
+            table.fields.push_back({ name, true, static_cast<unsigned>(i),
+                uniqueName(mangle(name, false), i, taken) });
+        }
+    }
+    return table;
+}
+
+void writeSyntaxHeader(std::ostream& out, const Grammar& grammar,
+    const TSLanguage* lang, const SymbolTable& table)
+{
+    out << "/**\n"
+        << " * @file tree_sitter/cxx/syntax/" << grammar.file << ".h\n"
+        << " * @brief Symbol and field IDs of the " << grammar.name << " grammar.\n"
+        << " *\n"
+        << " * Generated by tree-sitter-syntaxgen from the grammar's parser tables.\n"
+        << " * Do not edit.\n"
+        << " */\n"
+        << "#pragma once\n\n"
+        << "#include <cstdint>\n"
+        << "#include \"tree_sitter/api.h\"\n\n"
+        << "namespace TreeSitter::" << grammar.name << " {\n\n"
+        << "/** ABI version of the grammar these IDs were read from. */\n"
+        << "constexpr uint32_t Version = " << ts_language_version(lang) << ";\n"
+        << "/** Number of symbols, see Language.nodeTypeCount(). */\n"
+        << "constexpr uint32_t SymbolCount = " << ts_language_symbol_count(lang) << ";\n"
+        << "/** Number of fields, see Language.fieldCount(). */\n"
+        << "constexpr uint32_t FieldCount = " << ts_language_field_count(lang) << ";\n\n";
+
+    out << "/**\n"
+        << " * Visible node types, as returned by Node.typeId().\n"
+        << " *\n"
+        << " * Anonymous node types are prefixed with `anon_`, and punctuation\n"
+        << " * is spelled out: `\"+=\"` is `anon_plus_eq`. Names that are C++\n"
+        << " * keywords or common macros get a trailing underscore.\n"
+        << " */\n"
+        << "namespace Sym {\n"
+        << "enum : TSSymbol {\n";
+    for (const Entry& entry : table.symbols) {
+        out << "    " << entry.identifier << " = " << entry.id
+            << ", // " << quote(entry.name) << "\n";
+    }
+    out << "    ERROR_ = 0xFFFF, // \"ERROR\"\n"
+        << "};\n"
+        << "}\n\n";
+
+    out << "/** Fields, for Node.childForFieldId() and FieldId. */\n"
+        << "namespace Field {\n"
+        << "enum : TSFieldId {\n";
+    for (const Entry& entry : table.fields) {
+        out << "    " << entry.identifier << " = " << entry.id << ",\n";
+    }
+    out << "};\n"
+        << "}\n\n"
+        << "}\n";
+}
+
+/**
+ * @brief A parsed JSON value.
+ *
+ * Just enough JSON for `node-types.json`: numbers are kept as text and
+ * objects keep their key order.
+ */
+struct Json {
+    enum Kind { Null, Bool, Number, String, Array, Object };
+
+    Kind kind = Null;
+    bool boolean = false;
+    std::string string;
+    std::vector<Json> array;
+    std::vector<std::pair<std::string, Json>> object;
+
+    const Json* get(std::string_view key) const {
+        for (const auto& member : object) {
+            if (member.first == key) {
+                return &member.second;
+            }
+        }
+        return nullptr;
+    }
+};
+
+class JsonReader {
+public:
+    explicit JsonReader(const std::string& text) : m_text(text) { }
+
+    Json read() {
+        Json value = readValue();
+        skipSpace();
+        if (m_pos != m_text.size()) {
+            fail("trailing characters");
+        }
+        return value;
+    }
+private:
+    [[noreturn]] void fail(const char* message) const {
+        throw std::runtime_error(std::string("Invalid JSON at offset ")
+            + std::to_string(m_pos) + ": " + message);
+    }
+
+    void skipSpace() {
+        while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos]))) {
+            m_pos++;
+        }
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (m_pos < m_text.size() && m_text[m_pos] == c) {
+            m_pos++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!consume(c)) {
+            fail("unexpected character");
+        }
+    }
+
+    bool consumeWord(std::string_view word) {
+        if (m_text.compare(m_pos, word.size(), word) == 0) {
+            m_pos += word.size();
+            return true;
+        }
+        return false;
+    }
+
+    Json readValue() {
+        skipSpace();
+        if (m_pos >= m_text.size()) {
+            fail("unexpected end");
+        }
+        Json value;
+        const char c = m_text[m_pos];
+        if (c == '{') {
+            m_pos++;
+            value.kind = Json::Object;
+            if (consume('}')) {
+                return value;
+            }
+            do {
+                skipSpace();
+                std::string key = readString();
+                expect(':');
+                value.object.emplace_back(std::move(key), readValue());
+            } while (consume(','));
+            expect('}');
+        } else if (c == '[') {
+            m_pos++;
+            value.kind = Json::Array;
+            if (consume(']')) {
+                return value;
+            }
+            do {
+                value.array.push_back(readValue());
+            } while (consume(','));
+            expect(']');
+        } else if (c == '"') {
+            value.kind = Json::String;
+            value.string = readString();
+        } else if (consumeWord("true")) {
+            value.kind = Json::Bool;
+            value.boolean = true;
+        } else if (consumeWord("false")) {
+            value.kind = Json::Bool;
+        } else if (consumeWord("null")) {
+            value.kind = Json::Null;
+        } else if (c == '-' || std::isdigit(static_cast<unsigned char>(c))) {
+            value.kind = Json::Number;
+            while (m_pos < m_text.size() && std::strchr("+-.eE0123456789", m_text[m_pos]) != nullptr) {
+                value.string += m_text[m_pos++];
+            }
+        } else {
+            fail("unexpected character");
+        }
+        return value;
+    }
+
+    unsigned readHex4() {
+        if (m_pos + 4 > m_text.size()) {
+            fail("short escape");
+        }
+        unsigned value = 0;
+        for (int i=0; i<4; i++) {
+            const char c = m_text[m_pos++];
+            value <<= 4;
+            if (c >= '0' && c <= '9') {
+                value |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                value |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                value |= c - 'A' + 10;
+            } else {
+                fail("bad escape");
+            }
+        }
+        return value;
+    }
+
+    static void appendUtf8(std::string& out, unsigned cp) {
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xc0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3f));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xe0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+            out += static_cast<char>(0x80 | (cp & 0x3f));
+        } else {
+            out += static_cast<char>(0xf0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+            out += static_cast<char>(0x80 | (cp & 0x3f));
+        }
+    }
+
+    std::string readString() {
+        if (m_pos >= m_text.size() || m_text[m_pos] != '"') {
+            fail("expected a string");
+        }
+        m_pos++;
+        std::string result;
+        while (true) {
+            if (m_pos >= m_text.size()) {
+                fail("unterminated string");
+            }
+            const char c = m_text[m_pos++];
+            if (c == '"') {
+                return result;
+            }
+            if (c != '\\') {
+                result += c;
+                continue;
+            }
+            if (m_pos >= m_text.size()) {
+                fail("unterminated string");
+            }
+            const char escape = m_text[m_pos++];
+            switch (escape) {
+            case 'b': result += '\b'; break;
+            case 'f': result += '\f'; break;
+            case 'n': result += '\n'; break;
+            case 'r': result += '\r'; break;
+            case 't': result += '\t'; break;
+            case 'u': {
+                unsigned cp = readHex4();
+                if (cp >= 0xd800 && cp < 0xdc00 && consumeWord("\\u")) {
+                    const unsigned low = readHex4();
+                    cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                }
+                appendUtf8(result, cp);
+                break;
+            }
+            default: result += escape;
+            }
+        }
+    }
+
+    const std::string& m_text;
+    size_t m_pos = 0;
+};
+
+/** A field of a node type, from `node-types.json`. */
+struct FieldInfo {
+    std::string name;
+    bool multiple = false;
+    /** Possible node types, as (type, named) pairs. */
+    std::vector<std::pair<std::string, bool>> types;
+};
+
+/** A named node type, from `node-types.json`. */
+struct NodeInfo {
+    std::string type;
+    std::string className;
+    const Entry* symbol = nullptr;
+    std::vector<FieldInfo> fields;
+};
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot read " + path);
+    }
+    std::ostringstream buffer;
+    buffer << in.rdbuf();
+    return buffer.str();
+}
+
+/** `function_definition` becomes `FunctionDefinition`. */
+std::string className(std::string_view type) {
+    std::string result;
+    bool upper = true;
+    for (const char c : type) {
+        if (!std::isalnum(static_cast<unsigned char>(c))) {
+            upper = true;
+            continue;
+        }
+        result += upper ? static_cast<char>(std::toupper(static_cast<unsigned char>(c))) : c;
+        upper = false;
+    }
+    if (result.empty() || std::isdigit(static_cast<unsigned char>(result[0]))) {
+        result = "Node" + result;
+    }
+    return result;
+}
+
+/** Named node types with a symbol, skipping supertypes. */
+std::vector<NodeInfo> readNodeTypes(const std::string& path, const SymbolTable& table) {
+    const Json root = JsonReader(readFile(path)).read();
+    std::vector<NodeInfo> nodes;
+    std::set<std::string> taken = RESERVED_CLASSES;
+
+    for (const Json& entry : root.array) {
+        const Json* type = entry.get("type");
+        const Json* named = entry.get("named");
+        if (type == nullptr || named == nullptr || !named->boolean || entry.get("subtypes") != nullptr) {
+            continue;
+        }
+        NodeInfo node;
+        node.type = type->string;
+        node.symbol = table.symbol(node.type, true);
+        if (node.symbol == nullptr) {
+            continue;
+        }
+        node.className = className(node.type);
+        while (!taken.insert(node.className).second) {
+            node.className += "Node";
+        }
+
+        const Json* fields = entry.get("fields");
+        if (fields != nullptr) {
+            for (const auto& [name, info] : fields->object) {
+                FieldInfo field;
+                field.name = name;
+                const Json* multiple = info.get("multiple");
+                field.multiple = multiple != nullptr && multiple->boolean;
+                const Json* types = info.get("types");
+                if (types != nullptr) {
+                    for (const Json& t : types->array) {
+                        const Json* tName = t.get("type");
+                        const Json* tNamed = t.get("named");
+                        if (tName != nullptr && tNamed != nullptr) {
+                            field.types.emplace_back(tName->string, tNamed->boolean);
+                        }
+                    }
+                }
+                node.fields.push_back(std::move(field));
+            }
+        }
+        nodes.push_back(std::move(node));
+    }
+    return nodes;
+}
+
+void writeTypedHeader(std::ostream& out, const Grammar& grammar,
+    const SymbolTable& table, const std::vector<NodeInfo>& nodes)
+{
+    std::map<std::string, std::string> classes;
+    for (const NodeInfo& node : nodes) {
+        classes[node.type] = node.className;
+    }
+
+    out << "/**\n"
+        << " * @file tree_sitter/cxx/typed/" << grammar.file << ".h\n"
+        << " * @brief Typed node wrappers of the " << grammar.name << " grammar.\n"
+        << " *\n"
+        << " * Generated by tree-sitter-syntaxgen from the grammar's node-types.json.\n"
+        << " * Do not edit.\n"
+        << " */\n"
+        << "#pragma once\n\n"
+        << "#include <optional>\n"
+        << "#include <vector>\n"
+        << "#include \"tree_sitter/api.h\"\n"
+        << "#include \"tree_sitter/cxx/syntax/" << grammar.file << ".h\"\n"
+        << "#include \"tree_sitter/cxx/typed.h\"\n\n"
+        << "namespace TreeSitter::" << grammar.name << " {\n\n";
+
+    for (const NodeInfo& node : nodes) {
+        out << "class " << node.className << ";\n";
+    }
+    out << "\n";
+
+    // Accessors are defined after every class, since they return
+    // classes declared further down.
+    std::ostringstream definitions;
+    for (const NodeInfo& node : nodes) {
+        out << "/** Node of type `" << node.type << "`. */\n"
+            << "class " << node.className << " : public TypedNode {\n"
+            << "public:\n"
+            << "    static constexpr TSSymbol Symbol = Sym::" << node.symbol->identifier << ";\n"
+            << "    using TypedNode::TypedNode;\n"
+            << "    /** Returns `true` if `node` has type `" << node.type << "`. */\n"
+            << "    static bool is(TSNode node) { return ts_node_symbol(node) == Symbol; }\n";
+
+        std::set<std::string> members = RESERVED_MEMBERS;
+        for (const FieldInfo& field : node.fields) {
+            const Entry* id = table.field(field.name);
+            if (id == nullptr) {
+                continue;
+            }
+            std::string accessor = mangle(field.name, false);
+            while (!members.insert(accessor).second) {
+                accessor += '_';
+            }
+
+            // Fields that always hold one named node type return its
+            // class, others return a plain TypedNode.
+            std::string valueType = "TypedNode";
+            if (field.types.size() == 1 && field.types[0].second) {
+                const auto it = classes.find(field.types[0].first);
+                if (it != classes.end()) {
+                    valueType = it->second;
+                }
+            }
+            const std::string returnType = field.multiple
+                ? "std::vector<" + valueType + ">"
+                : "std::optional<" + valueType + ">";
+
+            out << "\n    /** The `" << field.name << "` " << (field.multiple ? "children" : "child") << ". */\n"
+                << "    " << returnType << " " << accessor << "() const;\n";
+            definitions << "inline " << returnType << " " << node.className << "::" << accessor << "() const {\n"
+                << "    return " << (field.multiple ? "fieldChildren<" : "fieldChild<") << valueType
+                << ">(Field::" << id->identifier << ");\n"
+                << "}\n\n";
+        }
+        out << "};\n\n";
+    }
+
+    out << definitions.str()
+        << "}\n";
+}
+
+bool writeFile(const std::string& path, const std::string& contents) {
+    std::ofstream out(path, std::ios::binary);
+    out << contents;
+    if (!out) {
+        std::cerr << "Cannot write " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <output directory> <grammar directory>\n";
+        return 2;
+    }
+    const std::string directory = argv[1];
+    const std::string grammars = argv[2];
+
+    try {
+        for (const Grammar& grammar : GRAMMARS) {
+            const TSLanguage* lang = grammar.language();
+            const SymbolTable table = buildSymbolTable(lang);
+
+            std::ostringstream syntax;
+            writeSyntaxHeader(syntax, grammar, lang, table);
+            if (!writeFile(directory + "/syntax/" + grammar.file + ".h", syntax.str())) {
+                return 1;
+            }
+
+            const auto nodes = readNodeTypes(grammars + "/" + grammar.nodeTypes, table);
+            std::ostringstream typed;
+            writeTypedHeader(typed, grammar, table, nodes);
+            if (!writeFile(directory + "/typed/" + grammar.file + ".h", typed.str())) {
+                return 1;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    std::ostringstream all;
+    all << "/**\n"
+        << " * @file tree_sitter/cxx/syntax.h\n"
+        << " * @brief Symbol and field IDs of every built-in grammar.\n"
+        << " *\n"
+        << " * Generated by tree-sitter-syntaxgen. Do not edit.\n"
+        << " */\n"
+        << "#pragma once\n\n";
+    for (const Grammar& grammar : GRAMMARS) {
+        all << "#include \"tree_sitter/cxx/syntax/" << grammar.file << ".h\"\n";
+    }
+    return writeFile(directory + "/syntax.h", all.str()) ? 0 : 1;
+}